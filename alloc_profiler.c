@@ -0,0 +1,777 @@
+// Allocation profiler, loaded into any binary with
+//
+//     LD_PRELOAD=./liballocprofile.so <program>
+//
+// Every allocation carries a small header recording its size and birth time.
+// The pointers handed out are also kept in a table striped over many locks,
+// which alone decides whether free and realloc were given one of them: the
+// bytes in front of a block of the real allocator can hold anything,
+// including a valid header. Threads count into histograms of their own, with
+// no I/O on the fast path, and the histograms are merged into a report when
+// the process exits or receives PROFILE_SIGNAL.
+//
+// Environment:
+//     MEMPROFILE_OUTPUT  write the report as JSON to this file instead of
+//                        printing it to stderr
+//     MEMPROFILE_SIGNAL  signal number that writes a report (default SIGUSR2,
+//                        0 for none)
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PROFILE_HEADER 16         // Header bytes ahead of every allocation
+#define PROFILE_SIZE_CLASSES 49   // Class k holds sizes in [2^(k-1), 2^k)
+#define PROFILE_LIFETIME_CLASSES 33  // Class k: [2^(k-1), 2^k) microseconds
+#define PROFILE_FLUSH_BYTES 65536  // Live-byte drift a thread keeps locally
+#define PROFILE_REPORT_SIZE 65536
+#define PROFILE_SIGNAL SIGUSR2
+#define PROFILE_OWNED_STRIPES 64     // Locks over the table of pointers
+#define PROFILE_OWNED_MIN_SLOTS 1024  // Smallest table of a stripe
+#define PROFILE_OWNED_REMOVED 1       // Slot of a pointer that was freed
+
+// Calls counted by the profiler.
+#define PROFILE_MALLOC 0
+#define PROFILE_CALLOC 1
+#define PROFILE_REALLOC 2
+#define PROFILE_ALIGNED 3  // memalign, posix_memalign, aligned_alloc, valloc
+#define PROFILE_FREE 4
+#define PROFILE_NUM_CALLS 5
+
+static const char *call_names[PROFILE_NUM_CALLS] = {
+    "malloc", "calloc", "realloc", "aligned", "free"};
+
+typedef struct {
+    uint64_t size;    // Requested size
+    uint32_t birth;   // Monotonic clock in microseconds, modulo 2^32
+    uint32_t offset;  // Distance from the underlying block to the user pointer
+} ProfileHeader;
+
+// Counters of one thread. Only the owner writes them; reports read them
+// while they change, so every access is a relaxed atomic.
+typedef struct ProfileStats {
+    struct ProfileStats *next;
+    uint64_t calls[PROFILE_NUM_CALLS];
+    uint64_t size_counts[PROFILE_SIZE_CLASSES];
+    uint64_t size_bytes[PROFILE_SIZE_CLASSES];
+    uint64_t lifetimes[PROFILE_LIFETIME_CLASSES];
+    uint64_t allocated_bytes;
+    uint64_t freed_bytes;
+    int64_t live_delta;  // Live bytes not yet added to live_bytes
+} ProfileStats;
+
+#define stat_load(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define stat_add(field, n) \
+    __atomic_store_n(&(field), stat_load(field) + (n), __ATOMIC_RELAXED)
+
+char tmpbuff[1024];
+unsigned long tmppos = 0;
+unsigned long tmpallocs = 0;
+
+/*=========================================================
+ * interception points
+ */
+
+static void *(*myfn_calloc)(size_t nmemb, size_t size);
+static void *(*myfn_malloc)(size_t size);
+static void (*myfn_free)(void *ptr);
+static void *(*myfn_realloc)(void *ptr, size_t size);
+static void *(*myfn_memalign)(size_t blocksize, size_t bytes);
+static size_t (*myfn_malloc_usable_size)(void *ptr);
+
+static ProfileStats *all_stats;  // Every thread's counters, never freed
+static int64_t live_bytes;
+static int64_t peak_bytes;
+static int report_json;     // Whether MEMPROFILE_OUTPUT is set
+static int report_fd = 2;   // The JSON file, or a copy of stderr
+static int reporting;
+
+static __thread ProfileStats *thread_stats
+    __attribute__((tls_model("initial-exec")));
+
+static void init() {
+    myfn_malloc = dlsym(RTLD_NEXT, "malloc");
+    myfn_free = dlsym(RTLD_NEXT, "free");
+    myfn_calloc = dlsym(RTLD_NEXT, "calloc");
+    myfn_realloc = dlsym(RTLD_NEXT, "realloc");
+    myfn_memalign = dlsym(RTLD_NEXT, "memalign");
+    myfn_malloc_usable_size = dlsym(RTLD_NEXT, "malloc_usable_size");
+
+    if (!myfn_malloc || !myfn_free || !myfn_calloc || !myfn_realloc ||
+        !myfn_memalign || !myfn_malloc_usable_size) {
+        fprintf(stderr, "Error in `dlsym`: %s\n", dlerror());
+        exit(1);
+    }
+}
+
+/**
+ * @brief Serves allocations made by dlsym while the real allocator is being
+ * looked up.
+ *
+ * @param size The size of the allocation.
+ * @return A pointer into tmpbuff.
+ */
+static void *tmp_alloc(size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    if (tmppos + size >= sizeof(tmpbuff)) {
+        fprintf(stderr,
+                "allocprofile: too much memory requested during "
+                "initialisation - increase tmpbuff size\n");
+        exit(1);
+    }
+    void *retptr = tmpbuff + tmppos;
+    tmppos += size;
+    ++tmpallocs;
+    return retptr;
+}
+
+static int is_tmp(void *ptr) {
+    return ptr >= (void *)tmpbuff && ptr < (void *)(tmpbuff + sizeof(tmpbuff));
+}
+
+/**
+ * @brief Looks up the real allocator on first use.
+ *
+ * @return 1 if the real allocator is available, 0 while it is being looked up.
+ */
+static int ensure_init() {
+    static int initializing = 0;
+    if (myfn_malloc) return 1;
+    if (initializing) return 0;
+    initializing = 1;
+    init();
+    initializing = 0;
+    return 1;
+}
+
+// Lifetimes are differences of two readings, so wrapping is harmless.
+static uint32_t now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Returns the log2 class of a value: 0 for 0, k for [2^(k-1), 2^k).
+ */
+static int class_of(uint64_t value, int num_classes) {
+    int k = value ? 64 - __builtin_clzll(value) : 0;
+    return k < num_classes ? k : num_classes - 1;
+}
+
+/**
+ * @brief Returns the calling thread's counters, registering them on first
+ * use.
+ *
+ * @return The counters, or NULL if they could not be allocated.
+ */
+static ProfileStats *get_stats() {
+    if (thread_stats) return thread_stats;
+    ProfileStats *stats = myfn_calloc(1, sizeof(ProfileStats));
+    if (!stats) return NULL;
+    stats->next = __atomic_load_n(&all_stats, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&all_stats, &stats->next, stats, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    return thread_stats = stats;
+}
+
+/**
+ * @brief Adds a thread's live-byte drift to the process total and raises the
+ * peak. Peaks are therefore exact to PROFILE_FLUSH_BYTES per thread.
+ *
+ * @param stats The thread's counters.
+ */
+static void flush_live(ProfileStats *stats) {
+    int64_t live = __atomic_add_fetch(&live_bytes, stat_load(stats->live_delta),
+                                      __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->live_delta, 0, __ATOMIC_RELAXED);
+    int64_t peak = __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak &&
+           !__atomic_compare_exchange_n(&peak_bytes, &peak, live, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void record_alloc(int call, size_t size) {
+    ProfileStats *stats = get_stats();
+    if (!stats) return;
+    int k = class_of(size, PROFILE_SIZE_CLASSES);
+    stat_add(stats->calls[call], 1);
+    stat_add(stats->size_counts[k], 1);
+    stat_add(stats->size_bytes[k], size);
+    stat_add(stats->allocated_bytes, size);
+    stat_add(stats->live_delta, (int64_t)size);
+    if (stat_load(stats->live_delta) > PROFILE_FLUSH_BYTES) flush_live(stats);
+}
+
+static void record_free(ProfileHeader *header) {
+    ProfileStats *stats = get_stats();
+    if (!stats) return;
+    size_t size = header->size;
+    uint32_t lifetime = now_us() - header->birth;
+    stat_add(stats->calls[PROFILE_FREE], 1);
+    stat_add(stats->lifetimes[class_of(lifetime, PROFILE_LIFETIME_CLASSES)], 1);
+    stat_add(stats->freed_bytes, size);
+    stat_add(stats->live_delta, -(int64_t)size);
+    if (stat_load(stats->live_delta) < -PROFILE_FLUSH_BYTES) flush_live(stats);
+}
+
+/*=========================================================
+ * pointers handed out
+ */
+
+// An open-addressing set of the pointers of one stripe of addresses. The
+// slots are mapped directly, so the table never calls back into malloc.
+typedef struct {
+    pthread_mutex_t lock;
+    uintptr_t *slots;  // 0 for empty, PROFILE_OWNED_REMOVED for freed
+    size_t capacity;   // A power of two, or 0 before the first pointer
+    size_t used;       // Slots that are not empty
+    size_t count;      // Slots holding a pointer
+} __attribute__((aligned(64))) OwnedStripe;
+
+static OwnedStripe owned[PROFILE_OWNED_STRIPES] = {
+    [0 ... PROFILE_OWNED_STRIPES - 1] = {.lock = PTHREAD_MUTEX_INITIALIZER}};
+
+static uint64_t owned_hash(uintptr_t ptr) {
+    uint64_t hash = (ptr >> 4) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 32);
+}
+
+static OwnedStripe *owned_stripe(uint64_t hash) {
+    return &owned[hash % PROFILE_OWNED_STRIPES];
+}
+
+/**
+ * @brief Moves a stripe's pointers to a table four times their number,
+ * dropping the slots of freed pointers. The stripe must be locked.
+ *
+ * @param stripe The stripe.
+ */
+static void owned_grow(OwnedStripe *stripe) {
+    size_t capacity = PROFILE_OWNED_MIN_SLOTS;
+    while (capacity < 4 * (stripe->count + 1)) capacity <<= 1;
+    uintptr_t *slots = mmap(NULL, capacity * sizeof(uintptr_t),
+                            PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slots == MAP_FAILED) {
+        // Untracked pointers could not be freed correctly later.
+        static const char message[] =
+            "allocprofile: no memory left for the table of allocations\n";
+        ssize_t written = write(2, message, sizeof(message) - 1);
+        (void)written;
+        abort();
+    }
+
+    for (size_t i = 0; i < stripe->capacity; i++) {
+        uintptr_t ptr = stripe->slots[i];
+        if (ptr <= PROFILE_OWNED_REMOVED) continue;
+        size_t j = owned_hash(ptr) >> 6;
+        while (slots[j & (capacity - 1)]) j++;
+        slots[j & (capacity - 1)] = ptr;
+    }
+    if (stripe->slots)
+        munmap(stripe->slots, stripe->capacity * sizeof(uintptr_t));
+    stripe->slots = slots;
+    stripe->capacity = capacity;
+    stripe->used = stripe->count;
+}
+
+/**
+ * @brief Finds the slot of a pointer. The stripe must be locked.
+ *
+ * @return The slot, or NULL if the pointer is not in the table.
+ */
+static uintptr_t *owned_find(OwnedStripe *stripe, uint64_t hash,
+                             uintptr_t ptr) {
+    if (!stripe->capacity) return NULL;
+    size_t mask = stripe->capacity - 1;
+    for (size_t i = hash >> 6;; i++) {
+        uintptr_t *slot = &stripe->slots[i & mask];
+        if (*slot == ptr) return slot;
+        if (!*slot) return NULL;
+    }
+}
+
+/**
+ * @brief Records a pointer handed out by the profiler.
+ */
+static void owned_add(void *ptr) {
+    uint64_t hash = owned_hash((uintptr_t)ptr);
+    OwnedStripe *stripe = owned_stripe(hash);
+    pthread_mutex_lock(&stripe->lock);
+    if (2 * (stripe->used + 1) > stripe->capacity) owned_grow(stripe);
+    size_t mask = stripe->capacity - 1;
+    size_t i = hash >> 6;
+    while (stripe->slots[i & mask] > PROFILE_OWNED_REMOVED) i++;
+    if (!stripe->slots[i & mask]) stripe->used++;
+    stripe->slots[i & mask] = (uintptr_t)ptr;
+    stripe->count++;
+    pthread_mutex_unlock(&stripe->lock);
+}
+
+/**
+ * @brief Forgets a pointer handed out by the profiler.
+ *
+ * @return 1 if the pointer was handed out by the profiler, 0 otherwise.
+ */
+static int owned_remove(void *ptr) {
+    uint64_t hash = owned_hash((uintptr_t)ptr);
+    OwnedStripe *stripe = owned_stripe(hash);
+    pthread_mutex_lock(&stripe->lock);
+    uintptr_t *slot = owned_find(stripe, hash, (uintptr_t)ptr);
+    if (slot) {
+        *slot = PROFILE_OWNED_REMOVED;
+        stripe->count--;
+    }
+    pthread_mutex_unlock(&stripe->lock);
+    return slot != NULL;
+}
+
+/**
+ * @brief Checks whether a pointer was handed out by the profiler.
+ */
+static int owned_contains(void *ptr) {
+    uint64_t hash = owned_hash((uintptr_t)ptr);
+    OwnedStripe *stripe = owned_stripe(hash);
+    pthread_mutex_lock(&stripe->lock);
+    int found = owned_find(stripe, hash, (uintptr_t)ptr) != NULL;
+    pthread_mutex_unlock(&stripe->lock);
+    return found;
+}
+
+// A child forked while another thread holds a stripe would never get it.
+static void owned_lock_all() {
+    for (int i = 0; i < PROFILE_OWNED_STRIPES; i++)
+        pthread_mutex_lock(&owned[i].lock);
+}
+
+static void owned_unlock_all() {
+    for (int i = PROFILE_OWNED_STRIPES - 1; i >= 0; i--)
+        pthread_mutex_unlock(&owned[i].lock);
+}
+
+static ProfileHeader *header_of(void *ptr) {
+    return (ProfileHeader *)((char *)ptr - PROFILE_HEADER);
+}
+
+/**
+ * @brief Allocates a block with room for the header in front of it.
+ *
+ * @param call The interposed call, for the counters.
+ * @param size The requested size.
+ * @param alignment The alignment of the user pointer, a power of two.
+ * @param zero Whether to zero the block.
+ * @return The user pointer, or NULL on failure.
+ */
+static void *profile_alloc(int call, size_t size, size_t alignment, int zero) {
+    size_t offset = alignment > PROFILE_HEADER ? alignment : PROFILE_HEADER;
+    if (size > SIZE_MAX - offset) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    char *base;
+    if (offset == PROFILE_HEADER)
+        base = zero ? myfn_calloc(1, size + offset) : myfn_malloc(size + offset);
+    else
+        base = myfn_memalign(alignment, size + offset);
+    if (!base) return NULL;
+    if (zero && offset != PROFILE_HEADER) memset(base + offset, 0, size);
+
+    ProfileHeader *header = (ProfileHeader *)(base + offset - PROFILE_HEADER);
+    header->size = size;
+    header->birth = now_us();
+    header->offset = offset;
+    record_alloc(call, size);
+    owned_add(base + offset);
+    return base + offset;
+}
+
+void *malloc(size_t size) {
+    if (!ensure_init()) return tmp_alloc(size);
+    return profile_alloc(PROFILE_MALLOC, size, PROFILE_HEADER, 0);
+}
+
+void free(void *ptr) {
+    if (!ptr || is_tmp(ptr)) return;
+    if (!owned_remove(ptr)) {
+        myfn_free(ptr);
+        return;
+    }
+    ProfileHeader *header = header_of(ptr);
+    record_free(header);
+    myfn_free((char *)ptr - header->offset);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    if (size && nmemb > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (!ensure_init()) return memset(tmp_alloc(nmemb * size), 0, nmemb * size);
+    return profile_alloc(PROFILE_CALLOC, nmemb * size, PROFILE_HEADER, 1);
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (!ensure_init()) {
+        void *nptr = tmp_alloc(size);
+        if (ptr) {
+            size_t old_size = tmpbuff + sizeof(tmpbuff) - (char *)ptr;
+            memmove(nptr, ptr, old_size < size ? old_size : size);
+        }
+        return nptr;
+    }
+    if (!ptr) return profile_alloc(PROFILE_REALLOC, size, PROFILE_HEADER, 0);
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+
+    ProfileHeader *header = NULL;
+    if (!is_tmp(ptr)) {
+        if (!owned_contains(ptr)) return myfn_realloc(ptr, size);
+        header = header_of(ptr);
+    }
+    size_t old_size = header ? header->size
+                             : (size_t)(tmpbuff + sizeof(tmpbuff) - (char *)ptr);
+
+    if (header && header->offset == PROFILE_HEADER &&
+        size <= SIZE_MAX - PROFILE_HEADER) {
+        // The block keeps its birth time; only the size changes. The old
+        // pointer is forgotten first, since another thread may get its
+        // address from malloc as soon as the block moves.
+        owned_remove(ptr);
+        char *base = myfn_realloc((char *)ptr - PROFILE_HEADER,
+                                  size + PROFILE_HEADER);
+        if (!base) {
+            owned_add(ptr);
+            return NULL;
+        }
+        owned_add(base + PROFILE_HEADER);
+        header = (ProfileHeader *)base;
+        header->size = size;
+        ProfileStats *stats = get_stats();
+        if (stats) {
+            int k = class_of(size, PROFILE_SIZE_CLASSES);
+            stat_add(stats->calls[PROFILE_REALLOC], 1);
+            stat_add(stats->size_counts[k], 1);
+            stat_add(stats->size_bytes[k], size);
+            stat_add(stats->allocated_bytes, size);
+            stat_add(stats->freed_bytes, old_size);
+            stat_add(stats->live_delta, (int64_t)size - (int64_t)old_size);
+            if (stat_load(stats->live_delta) > PROFILE_FLUSH_BYTES)
+                flush_live(stats);
+        }
+        return base + PROFILE_HEADER;
+    }
+
+    // Aligned and bootstrap blocks move to a fresh block.
+    void *nptr = profile_alloc(PROFILE_REALLOC, size, PROFILE_HEADER, 0);
+    if (!nptr) return NULL;
+    memcpy(nptr, ptr, old_size < size ? old_size : size);
+    free(ptr);
+    return nptr;
+}
+
+/**
+ * @brief Rounds an alignment up to a power of two.
+ */
+static size_t round_alignment(size_t alignment) {
+    size_t rounded = PROFILE_HEADER;
+    while (rounded < alignment) rounded <<= 1;
+    return rounded;
+}
+
+void *memalign(size_t blocksize, size_t bytes) {
+    if (!ensure_init()) return NULL;
+    return profile_alloc(PROFILE_ALIGNED, bytes, round_alignment(blocksize), 0);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)))
+        return EINVAL;
+    void *ptr = memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *memptr = ptr;
+    return 0;
+}
+
+void *valloc(size_t size) { return memalign(sysconf(_SC_PAGESIZE), size); }
+
+void *pvalloc(size_t size) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    return memalign(page, (size + page - 1) & ~(page - 1));
+}
+
+size_t malloc_usable_size(void *ptr) {
+    if (!ptr || is_tmp(ptr) || !ensure_init()) return 0;
+    if (!owned_contains(ptr)) return myfn_malloc_usable_size(ptr);
+    ProfileHeader *header = header_of(ptr);
+    return myfn_malloc_usable_size((char *)ptr - header->offset) -
+           header->offset;
+}
+
+/*=========================================================
+ * reporting
+ */
+
+static char report[PROFILE_REPORT_SIZE];
+static size_t report_length;
+
+// The report is formatted by hand rather than with printf, which is not
+// async-signal-safe.
+
+/**
+ * @brief Appends a string, padded with spaces to a field width.
+ *
+ * @param str The string.
+ * @param width Right-aligns in a field this wide if positive, left-aligns if
+ * negative.
+ */
+static void report_str(const char *str, int width) {
+    size_t length = strlen(str);
+    size_t field = width < 0 ? -width : width;
+    size_t pad = field > length ? field - length : 0;
+    if (report_length + pad + length > sizeof(report)) return;
+    if (width > 0) {
+        memset(report + report_length, ' ', pad);
+        report_length += pad;
+    }
+    memcpy(report + report_length, str, length);
+    report_length += length;
+    if (width < 0) {
+        memset(report + report_length, ' ', pad);
+        report_length += pad;
+    }
+}
+
+/**
+ * @brief Appends an unsigned integer in decimal, padded like report_str.
+ */
+static void report_uint(uint64_t value, int width) {
+    char digits[24];
+    char *p = digits + sizeof(digits);
+    *--p = '\0';
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    report_str(p, width);
+}
+
+/**
+ * @brief Appends a signed integer in decimal.
+ */
+static void report_int(int64_t value) {
+    if (value < 0) {
+        report_str("-", 0);
+        report_uint(-(uint64_t)value, 0);
+    } else {
+        report_uint(value, 0);
+    }
+}
+
+/**
+ * @brief Merges the counters of every thread, formats them and writes them
+ * out. Only async-signal-safe calls are made, so this also runs from the
+ * signal handler.
+ */
+static void profile_report() {
+    if (__atomic_exchange_n(&reporting, 1, __ATOMIC_ACQUIRE)) return;
+
+    ProfileStats total;
+    memset(&total, 0, sizeof(total));
+    int64_t live = __atomic_load_n(&live_bytes, __ATOMIC_RELAXED);
+    for (ProfileStats *stats = __atomic_load_n(&all_stats, __ATOMIC_ACQUIRE);
+         stats; stats = stats->next) {
+        for (int i = 0; i < PROFILE_NUM_CALLS; i++)
+            total.calls[i] += stat_load(stats->calls[i]);
+        for (int i = 0; i < PROFILE_SIZE_CLASSES; i++) {
+            total.size_counts[i] += stat_load(stats->size_counts[i]);
+            total.size_bytes[i] += stat_load(stats->size_bytes[i]);
+        }
+        for (int i = 0; i < PROFILE_LIFETIME_CLASSES; i++)
+            total.lifetimes[i] += stat_load(stats->lifetimes[i]);
+        total.allocated_bytes += stat_load(stats->allocated_bytes);
+        total.freed_bytes += stat_load(stats->freed_bytes);
+        live += stat_load(stats->live_delta);
+    }
+    int64_t peak = __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED);
+    if (live > peak) peak = live;
+
+    report_length = 0;
+    int json = report_json;
+    if (json) {
+        report_str("{\"pid\": ", 0);
+        report_int(getpid());
+        report_str(", \"calls\": {", 0);
+        for (int i = 0; i < PROFILE_NUM_CALLS; i++) {
+            report_str(i ? ", \"" : "\"", 0);
+            report_str(call_names[i], 0);
+            report_str("\": ", 0);
+            report_uint(total.calls[i], 0);
+        }
+        report_str("}, \"allocated_bytes\": ", 0);
+        report_uint(total.allocated_bytes, 0);
+        report_str(", \"freed_bytes\": ", 0);
+        report_uint(total.freed_bytes, 0);
+        report_str(", \"live_bytes\": ", 0);
+        report_int(live);
+        report_str(", \"peak_bytes\": ", 0);
+        report_int(peak);
+        report_str(", \"sizes\": [", 0);
+    } else {
+        report_str("allocprofile: pid ", 0);
+        report_int(getpid());
+        report_str("\n  calls:", 0);
+        for (int i = 0; i < PROFILE_NUM_CALLS; i++) {
+            report_str(" ", 0);
+            report_str(call_names[i], 0);
+            report_str("=", 0);
+            report_uint(total.calls[i], 0);
+        }
+        report_str("\n  bytes: allocated=", 0);
+        report_uint(total.allocated_bytes, 0);
+        report_str(" freed=", 0);
+        report_uint(total.freed_bytes, 0);
+        report_str(" live=", 0);
+        report_int(live);
+        report_str(" peak=", 0);
+        report_int(peak);
+        report_str("\n  ", 0);
+        report_str("size", -24);
+        report_str(" ", 0);
+        report_str("count", 12);
+        report_str(" ", 0);
+        report_str("bytes", 16);
+        report_str("\n", 0);
+    }
+
+    int first = 1;
+    for (int k = 0; k < PROFILE_SIZE_CLASSES; k++) {
+        if (!total.size_counts[k]) continue;
+        uint64_t low = k ? 1ull << (k - 1) : 0;
+        uint64_t high = k ? (1ull << k) - 1 : 0;
+        if (json) {
+            report_str(first ? "{\"min\": " : ", {\"min\": ", 0);
+            report_uint(low, 0);
+            report_str(", \"max\": ", 0);
+            report_uint(high, 0);
+            report_str(", \"count\": ", 0);
+            report_uint(total.size_counts[k], 0);
+            report_str(", \"bytes\": ", 0);
+            report_uint(total.size_bytes[k], 0);
+            report_str("}", 0);
+        } else {
+            report_str("  ", 0);
+            report_uint(low, 10);
+            report_str(" - ", 0);
+            report_uint(high, -10);
+            report_str(" ", 0);
+            report_uint(total.size_counts[k], 12);
+            report_str(" ", 0);
+            report_uint(total.size_bytes[k], 16);
+            report_str("\n", 0);
+        }
+        first = 0;
+    }
+
+    if (json) {
+        report_str("], \"lifetimes_us\": [", 0);
+    } else {
+        report_str("  ", 0);
+        report_str("lifetime (us)", -24);
+        report_str(" ", 0);
+        report_str("frees", 12);
+        report_str("\n", 0);
+    }
+    first = 1;
+    for (int k = 0; k < PROFILE_LIFETIME_CLASSES; k++) {
+        if (!total.lifetimes[k]) continue;
+        uint64_t low = k ? 1ull << (k - 1) : 0;
+        uint64_t high = k ? (1ull << k) - 1 : 0;
+        if (json) {
+            report_str(first ? "{\"min\": " : ", {\"min\": ", 0);
+            report_uint(low, 0);
+            report_str(", \"max\": ", 0);
+            report_uint(high, 0);
+            report_str(", \"count\": ", 0);
+            report_uint(total.lifetimes[k], 0);
+            report_str("}", 0);
+        } else {
+            report_str("  ", 0);
+            report_uint(low, 10);
+            report_str(" - ", 0);
+            report_uint(high, -10);
+            report_str(" ", 0);
+            report_uint(total.lifetimes[k], 12);
+            report_str("\n", 0);
+        }
+        first = 0;
+    }
+    if (json) report_str("]}\n", 0);
+
+    // The JSON file was opened at startup; each report replaces the last.
+    if (json && ftruncate(report_fd, 0) != 0) report_length = 0;
+    for (size_t done = 0; done < report_length;) {
+        ssize_t n = json ? pwrite(report_fd, report + done,
+                                  report_length - done, done)
+                         : write(report_fd, report + done,
+                                 report_length - done);
+        if (n <= 0) break;
+        done += n;
+    }
+
+    __atomic_store_n(&reporting, 0, __ATOMIC_RELEASE);
+}
+
+static void profile_signal(int signum) {
+    (void)signum;
+    int saved_errno = errno;
+    profile_report();
+    errno = saved_errno;
+}
+
+__attribute__((constructor)) static void profile_start() {
+    ensure_init();
+    pthread_atfork(owned_lock_all, owned_unlock_all, owned_unlock_all);
+    // Reports go to a descriptor above the ones programs use, which they may
+    // close. The output file is opened here because the signal handler may
+    // not call open.
+    const char *output_path = getenv("MEMPROFILE_OUTPUT");
+    int fd = output_path ? open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+                         : 2;
+    report_json = output_path != NULL;
+    report_fd = fd >= 0 ? fcntl(fd, F_DUPFD_CLOEXEC, 100) : -1;
+    if (report_fd < 0) report_fd = fd;
+    else if (output_path) close(fd);
+
+    const char *signal_name = getenv("MEMPROFILE_SIGNAL");
+    int signum = signal_name ? atoi(signal_name) : PROFILE_SIGNAL;
+    if (signum > 0) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = profile_signal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(signum, &action, NULL);
+    }
+}
+
+__attribute__((destructor)) static void profile_stop() { profile_report(); }
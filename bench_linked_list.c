@@ -0,0 +1,345 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common_defs.h"
+#include "linked_list.h"
+
+#define BENCH_MAX_THREADS 256
+#define BENCH_MAX_CONFIGS 16
+
+// Latency histogram: values below 16 ns get a bucket each, larger values 16
+// buckets per power of two, so percentiles are exact to about 6%.
+#define BENCH_SUB_BUCKETS 16
+#define BENCH_BUCKETS (48 * BENCH_SUB_BUCKETS)
+
+#define BENCH_OP_SEARCH 0
+#define BENCH_OP_INSERT 1
+#define BENCH_OP_DELETE 2
+#define BENCH_NUM_OPS 3
+
+static const char *op_names[BENCH_NUM_OPS] = {"search", "insert", "delete"};
+
+typedef struct {
+    int read_percent;  // Share of searches; the rest splits into inserts
+                       // and deletes
+    int num_keys;      // Keys are drawn from [0, num_keys)
+    double theta;      // Zipf skew, or 0 for uniform keys
+    double seconds;    // Duration of each run
+    int combining;     // Whether writes go through flat combining
+} BenchConfig;
+
+// Zipf generator of Gray et al., as used by YCSB.
+typedef struct {
+    int n;
+    double theta;
+    double alpha;
+    double zetan;
+    double eta;
+} Zipf;
+
+typedef struct {
+    Node **head;
+    const BenchConfig *config;
+    const Zipf *zipf;
+    const uint16_t *rank_keys;  // The key of each Zipf rank
+    my_barrier_t *barrier;
+    volatile int *stop;
+    uint64_t seed;
+    uint64_t ops[BENCH_NUM_OPS];
+    uint64_t histogram[BENCH_NUM_OPS][BENCH_BUCKETS];
+} BenchThread;
+
+static void zipf_init(Zipf *zipf, int n, double theta) {
+    zipf->n = n;
+    zipf->theta = theta;
+    zipf->alpha = 1.0 / (1.0 - theta);
+    zipf->zetan = 0;
+    for (int i = 1; i <= n; i++) zipf->zetan += 1.0 / pow(i, theta);
+    double zeta2 = 1.0 + 1.0 / pow(2, theta);
+    zipf->eta =
+        (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zipf->zetan);
+}
+
+/**
+ * @brief Draws a rank from a Zipf distribution; rank 0 is the most popular.
+ *
+ * @param zipf The distribution.
+ * @param u A uniform number in [0, 1).
+ * @return A rank in [0, n).
+ */
+static int zipf_next(const Zipf *zipf, double u) {
+    double uz = u * zipf->zetan;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + pow(0.5, zipf->theta)) return 1;
+    int rank = zipf->n * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha);
+    return rank < zipf->n ? rank : zipf->n - 1;
+}
+
+static uint64_t xorshift(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int bucket_of(uint64_t ns) {
+    if (ns < BENCH_SUB_BUCKETS) return ns;
+    int shift = 63 - __builtin_clzll(ns) - 4;
+    int bucket = shift * BENCH_SUB_BUCKETS + (ns >> shift);
+    return bucket < BENCH_BUCKETS ? bucket : BENCH_BUCKETS - 1;
+}
+
+static uint64_t bucket_value(int bucket) {
+    if (bucket < BENCH_SUB_BUCKETS) return bucket;
+    int shift = bucket / BENCH_SUB_BUCKETS - 1;
+    return (uint64_t)(BENCH_SUB_BUCKETS + bucket % BENCH_SUB_BUCKETS) << shift;
+}
+
+/**
+ * @brief Draws a key. Zipf ranks map to keys through a random permutation, so
+ * the popular keys are not all at the front of the list.
+ *
+ * @param data The thread's state.
+ * @return The key.
+ */
+static uint16_t next_key(BenchThread *data) {
+    uint64_t r = xorshift(&data->seed);
+    if (data->config->theta <= 0) return r % data->config->num_keys;
+    int rank = zipf_next(data->zipf, (r >> 11) * (1.0 / (1ull << 53)));
+    return data->rank_keys[rank];
+}
+
+/**
+ * @brief Fills an array with a random permutation of [0, count) by a
+ * Fisher-Yates shuffle.
+ *
+ * @param keys The array.
+ * @param count The number of keys.
+ */
+static void shuffle_keys(uint16_t *keys, int count) {
+    for (int i = 0; i < count; i++) keys[i] = i;
+    for (int i = count - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        uint16_t key = keys[i];
+        keys[i] = keys[j];
+        keys[j] = key;
+    }
+}
+
+static void *bench_thread(void *arg) {
+    BenchThread *data = (BenchThread *)arg;
+    my_barrier_wait(data->barrier);
+
+    while (!*data->stop) {
+        int op = BENCH_OP_SEARCH;
+        if ((int)(xorshift(&data->seed) % 100) >= data->config->read_percent)
+            op = xorshift(&data->seed) & 1 ? BENCH_OP_INSERT : BENCH_OP_DELETE;
+        uint16_t key = next_key(data);
+
+        uint64_t start = now_ns();
+        if (op == BENCH_OP_SEARCH)
+            list_search(data->head, key);
+        else if (op == BENCH_OP_INSERT)
+            list_insert(data->head, key);
+        else
+            list_delete(data->head, key);
+        uint64_t end = now_ns();
+
+        data->ops[op]++;
+        data->histogram[op][bucket_of(end - start)]++;
+    }
+    return NULL;
+}
+
+static uint64_t percentile(const uint64_t *histogram, uint64_t total,
+                           double fraction) {
+    uint64_t target = ceil(total * fraction);
+    uint64_t seen = 0;
+    for (int i = 0; i < BENCH_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen >= target && seen) return bucket_value(i);
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs one workload on a freshly filled list and prints a line per
+ * operation type.
+ *
+ * @param config The workload.
+ * @param num_threads The number of client threads.
+ */
+static void bench_run(const BenchConfig *config, int num_threads) {
+    // Inserts and deletes are equally likely, so the list stays near its
+    // initial size; the pool leaves room for drift.
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 4 * config->num_keys);
+    uint16_t *keys = malloc(config->num_keys * sizeof(uint16_t));
+    shuffle_keys(keys, config->num_keys);
+    for (int i = 0; i < config->num_keys; i++) list_insert(&head, keys[i]);
+    list_set_combining(config->combining);
+
+    // A second, independent permutation assigns the Zipf ranks to keys.
+    Zipf zipf;
+    if (config->theta > 0) zipf_init(&zipf, config->num_keys, config->theta);
+    shuffle_keys(keys, config->num_keys);
+
+    my_barrier_t barrier;
+    my_barrier_init(&barrier, num_threads + 1);
+    volatile int stop = 0;
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    BenchThread *thread_data = calloc(num_threads, sizeof(BenchThread));
+    for (int i = 0; i < num_threads; i++) {
+        thread_data[i] = (BenchThread){.head = &head,
+                                       .config = config,
+                                       .zipf = &zipf,
+                                       .rank_keys = keys,
+                                       .barrier = &barrier,
+                                       .stop = &stop,
+                                       .seed = 0x9e3779b97f4a7c15ull * (i + 1)};
+        pthread_create(&threads[i], NULL, bench_thread, &thread_data[i]);
+    }
+
+    my_barrier_wait(&barrier);
+    uint64_t start = now_ns();
+    usleep(config->seconds * 1e6);
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    double seconds = (now_ns() - start) / 1e9;
+
+    for (int op = 0; op < BENCH_NUM_OPS; op++) {
+        uint64_t histogram[BENCH_BUCKETS] = {0};
+        uint64_t total = 0;
+        for (int i = 0; i < num_threads; i++) {
+            total += thread_data[i].ops[op];
+            for (int b = 0; b < BENCH_BUCKETS; b++)
+                histogram[b] += thread_data[i].histogram[op][b];
+        }
+        if (!total) continue;
+        printf("%7d  %3d/%-3d  %-12s  %-6s  %10.0f  %8" PRIu64 "  %8" PRIu64
+               "  %8" PRIu64 "  %8" PRIu64 "\n",
+               num_threads, config->read_percent, 100 - config->read_percent,
+               config->theta > 0 ? "zipf" : "uniform", op_names[op],
+               total / seconds, percentile(histogram, total, 0.5),
+               percentile(histogram, total, 0.9),
+               percentile(histogram, total, 0.99),
+               percentile(histogram, total, 0.999));
+    }
+
+    free(thread_data);
+    free(threads);
+    free(keys);
+    my_barrier_destroy(&barrier);
+    list_set_combining(0);
+    list_cleanup(&head);
+}
+
+/**
+ * @brief Parses a comma-separated list of integers.
+ *
+ * @param text The list.
+ * @param values Receives the integers.
+ * @param max The capacity of values.
+ * @return The number of integers parsed.
+ */
+static int parse_list(const char *text, int *values, int max) {
+    int count = 0;
+    while (*text && count < max) {
+        char *end;
+        values[count++] = strtol(text, &end, 10);
+        if (*end != ',') break;
+        text = end + 1;
+    }
+    return count;
+}
+
+static void usage(const char *program) {
+    printf("Usage: %s [-t threads] [-r read_percent] [-k keys] [-z theta] "
+           "[-d seconds] [-c]\n",
+           program);
+    printf("  -t  comma-separated thread counts, 1 to %d (default 1,4,16)\n",
+           BENCH_MAX_THREADS);
+    printf("  -r  comma-separated read percentages (default 95,50)\n");
+    printf("  -k  number of distinct keys, 2 to 65536 (default 1024)\n");
+    printf("  -z  Zipf skew in (0, 1), or 0 for uniform keys (default 0)\n");
+    printf("  -d  seconds per run (default 1)\n");
+    printf("  -c  apply writes by flat combining\n");
+}
+
+int main(int argc, char *argv[]) {
+    int thread_counts[BENCH_MAX_CONFIGS] = {1, 4, 16};
+    int num_thread_counts = 3;
+    int read_percents[BENCH_MAX_CONFIGS] = {95, 50};
+    int num_read_percents = 2;
+    BenchConfig config = {.num_keys = 1024, .theta = 0, .seconds = 1};
+
+    int option;
+    while ((option = getopt(argc, argv, "t:r:k:z:d:ch")) != -1) {
+        switch (option) {
+            case 't':
+                num_thread_counts =
+                    parse_list(optarg, thread_counts, BENCH_MAX_CONFIGS);
+                break;
+            case 'r':
+                num_read_percents =
+                    parse_list(optarg, read_percents, BENCH_MAX_CONFIGS);
+                break;
+            case 'k':
+                config.num_keys = atoi(optarg);
+                break;
+            case 'z':
+                config.theta = atof(optarg);
+                break;
+            case 'd':
+                config.seconds = atof(optarg);
+                break;
+            case 'c':
+                config.combining = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (config.num_keys < 2 || config.num_keys > 65536 || config.theta < 0 ||
+        config.theta >= 1 || config.seconds <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (int i = 0; i < num_thread_counts; i++) {
+        if (thread_counts[i] < 1 || thread_counts[i] > BENCH_MAX_THREADS) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    for (int i = 0; i < num_read_percents; i++) {
+        if (read_percents[i] < 0 || read_percents[i] > 100) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    printf("keys: %d  seconds per run: %.1f  writes: %s\n", config.num_keys,
+           config.seconds, config.combining ? "combining" : "locking");
+    printf("threads  mix      dist          op         ops/s   p50(ns)   "
+           "p90(ns)   p99(ns)  p999(ns)\n");
+    for (int r = 0; r < num_read_percents; r++) {
+        config.read_percent = read_percents[r];
+        for (int t = 0; t < num_thread_counts; t++)
+            bench_run(&config, thread_counts[t]);
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "compact_list.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Resolves a link against the current memory pool.
+ *
+ * @param link The link to resolve.
+ * @return A pointer to the node, or NULL for COMPACT_LIST_NULL.
+ */
+CompactNode *compact_list_node(clist_link_t link) {
+    return compact_list_at(mem_base(), link);
+}
+
+/**
+ * @brief Allocates a node and returns its link.
+ *
+ * @param hint A node to allocate near, or NULL for the first free gap.
+ * @param data The data to store in the node.
+ * @return The link of the new node, or COMPACT_LIST_NULL if the allocation
+ * failed or landed beyond the reach of a 32-bit link.
+ */
+static clist_link_t node_alloc(CompactNode *hint, uint16_t data) {
+    CompactNode *node = hint ? mem_alloc_near(hint, sizeof(CompactNode))
+                             : mem_alloc(sizeof(CompactNode));
+    if (!node) return COMPACT_LIST_NULL;
+
+    size_t offset = (char *)node - (char *)mem_base();
+    if (offset >= COMPACT_LIST_NULL) {
+        mem_free(node);
+        return COMPACT_LIST_NULL;
+    }
+    node->next = COMPACT_LIST_NULL;
+    node->data = data;
+    node->flags = 0;
+    return offset;
+}
+
+/**
+ * @brief Initializes a list whose nodes link by 32-bit pool offsets.
+ *
+ * @param list A pointer to the list.
+ */
+void compact_list_init(CompactList *list) {
+    list->head = COMPACT_LIST_NULL;
+    list->tail = COMPACT_LIST_NULL;
+    pthread_rwlock_init(&list->lock, NULL);
+}
+
+/**
+ * @brief Appends the specified data to the end of the list.
+ *
+ * @param list A pointer to the list.
+ * @param data The data to insert.
+ * @return The link of the new node, or COMPACT_LIST_NULL if the allocation
+ * failed.
+ */
+clist_link_t compact_list_insert(CompactList *list, uint16_t data) {
+    clist_link_t link = node_alloc(NULL, data);
+    if (link == COMPACT_LIST_NULL) return link;
+
+    pthread_rwlock_wrlock(&list->lock);
+    if (list->tail != COMPACT_LIST_NULL)
+        compact_list_node(list->tail)->next = link;
+    else
+        list->head = link;
+    list->tail = link;
+    pthread_rwlock_unlock(&list->lock);
+    return link;
+}
+
+/**
+ * @brief Inserts the specified data after the given node.
+ *
+ * @param list A pointer to the list.
+ * @param prev The link of a node on the list.
+ * @param data The data to insert.
+ * @return The link of the new node, or COMPACT_LIST_NULL if the allocation
+ * failed.
+ */
+clist_link_t compact_list_insert_after(CompactList *list, clist_link_t prev,
+                                       uint16_t data) {
+    CompactNode *prev_node = compact_list_node(prev);
+    if (!prev_node) return COMPACT_LIST_NULL;
+
+    clist_link_t link = node_alloc(prev_node, data);
+    if (link == COMPACT_LIST_NULL) return link;
+
+    pthread_rwlock_wrlock(&list->lock);
+    compact_list_node(link)->next = prev_node->next;
+    prev_node->next = link;
+    if (list->tail == prev) list->tail = link;
+    pthread_rwlock_unlock(&list->lock);
+    return link;
+}
+
+/**
+ * @brief Removes the first node with the specified data.
+ *
+ * @param list A pointer to the list.
+ * @param data The data to remove.
+ */
+void compact_list_delete(CompactList *list, uint16_t data) {
+    pthread_rwlock_wrlock(&list->lock);
+
+    void *base = mem_base();
+    clist_link_t previous = COMPACT_LIST_NULL;
+    clist_link_t current = list->head;
+    while (current != COMPACT_LIST_NULL &&
+           compact_list_at(base, current)->data != data) {
+        previous = current;
+        current = compact_list_at(base, current)->next;
+    }
+
+    if (current != COMPACT_LIST_NULL) {
+        CompactNode *node = compact_list_at(base, current);
+        if (previous == COMPACT_LIST_NULL)
+            list->head = node->next;
+        else
+            compact_list_at(base, previous)->next = node->next;
+        if (list->tail == current) list->tail = previous;
+        mem_free(node);
+    }
+
+    pthread_rwlock_unlock(&list->lock);
+}
+
+/**
+ * @brief Searches for the first node with the specified data.
+ *
+ * @param list A pointer to the list.
+ * @param data The data to search for.
+ * @return The link of the node, or COMPACT_LIST_NULL if none matches.
+ */
+clist_link_t compact_list_search(CompactList *list, uint16_t data) {
+    pthread_rwlock_rdlock(&list->lock);
+
+    void *base = mem_base();
+    clist_link_t current = list->head;
+    while (current != COMPACT_LIST_NULL &&
+           compact_list_at(base, current)->data != data)
+        current = compact_list_at(base, current)->next;
+
+    pthread_rwlock_unlock(&list->lock);
+    return current;
+}
+
+/**
+ * @brief Prints all elements of the list.
+ *
+ * @param list A pointer to the list.
+ */
+void compact_list_display(CompactList *list) {
+    pthread_rwlock_rdlock(&list->lock);
+
+    void *base = mem_base();
+    printf("[");
+    for (clist_link_t current = list->head; current != COMPACT_LIST_NULL;) {
+        CompactNode *node = compact_list_at(base, current);
+        printf("%d", node->data);
+        current = node->next;
+        if (current != COMPACT_LIST_NULL) printf(", ");
+    }
+    printf("]");
+
+    pthread_rwlock_unlock(&list->lock);
+}
+
+/**
+ * @brief Counts the nodes by walking the list.
+ *
+ * @param list A pointer to the list.
+ * @return The number of nodes in the list.
+ */
+int compact_list_count_nodes(CompactList *list) {
+    pthread_rwlock_rdlock(&list->lock);
+
+    void *base = mem_base();
+    int count = 0;
+    for (clist_link_t current = list->head; current != COMPACT_LIST_NULL;
+         current = compact_list_at(base, current)->next)
+        count++;
+
+    pthread_rwlock_unlock(&list->lock);
+    return count;
+}
+
+/**
+ * @brief Frees every node of the list.
+ *
+ * @param list A pointer to the list.
+ */
+void compact_list_cleanup(CompactList *list) {
+    pthread_rwlock_wrlock(&list->lock);
+    void *base = mem_base();
+    clist_link_t current = list->head;
+    while (current != COMPACT_LIST_NULL) {
+        CompactNode *node = compact_list_at(base, current);
+        current = node->next;
+        mem_free(node);
+    }
+    list->head = COMPACT_LIST_NULL;
+    list->tail = COMPACT_LIST_NULL;
+    pthread_rwlock_unlock(&list->lock);
+    pthread_rwlock_destroy(&list->lock);
+}
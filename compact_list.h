@@ -0,0 +1,54 @@
+#ifndef COMPACT_LIST_H
+#define COMPACT_LIST_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory_manager.h"
+
+// A link is the byte offset of a node from the start of the memory pool, so
+// the list holds no pointers: a byte copy of the pool, together with the
+// list's head and tail links, is the same list wherever it is mapped. The
+// pool must be smaller than 4 GiB.
+typedef uint32_t clist_link_t;
+
+#define COMPACT_LIST_NULL UINT32_MAX
+
+// An 8-byte node, half the size of a pointer-linked Node.
+typedef struct {
+    clist_link_t next;
+    uint16_t data;
+    uint16_t flags;
+} CompactNode;
+
+typedef struct {
+    clist_link_t head;
+    clist_link_t tail;
+    pthread_rwlock_t lock;
+} CompactList;
+
+/**
+ * @brief Resolves a link against a pool mapped at `base`.
+ *
+ * @param base The start of the pool (or of a byte copy of it).
+ * @param link The link to resolve.
+ * @return A pointer to the node, or NULL for COMPACT_LIST_NULL.
+ */
+static inline CompactNode *compact_list_at(void *base, clist_link_t link) {
+    return link == COMPACT_LIST_NULL ? NULL
+                                     : (CompactNode *)((char *)base + link);
+}
+
+void compact_list_init(CompactList *list);
+clist_link_t compact_list_insert(CompactList *list, uint16_t data);
+clist_link_t compact_list_insert_after(CompactList *list, clist_link_t prev,
+                                       uint16_t data);
+void compact_list_delete(CompactList *list, uint16_t data);
+clist_link_t compact_list_search(CompactList *list, uint16_t data);
+CompactNode *compact_list_node(clist_link_t link);
+void compact_list_display(CompactList *list);
+int compact_list_count_nodes(CompactList *list);
+void compact_list_cleanup(CompactList *list);
+
+#endif
@@ -0,0 +1,130 @@
+#include "dist_rwlock.h"
+
+#include <sched.h>
+
+#define DIST_WRITER_NONE 0
+#define DIST_WRITER_WAITING 1
+#define DIST_WRITER_ACTIVE 2
+
+static int next_slot;
+static __thread int thread_slot = -1;
+
+/**
+ * @brief Returns the reader indicator of the calling thread, assigning one
+ * round-robin on first use.
+ *
+ * @param lock A pointer to the lock.
+ * @return A pointer to the reader slot.
+ */
+static ReaderSlot *reader_slot(dist_rwlock_t *lock) {
+    if (thread_slot < 0)
+        thread_slot = __atomic_fetch_add(&next_slot, 1, __ATOMIC_RELAXED) %
+                      DIST_RWLOCK_SLOTS;
+    return &lock->slots[thread_slot];
+}
+
+/**
+ * @brief Checks whether any reader holds or is entering the lock.
+ *
+ * @param lock A pointer to the lock.
+ * @return 1 if a reader indicator is set, 0 otherwise.
+ */
+static int readers_present(dist_rwlock_t *lock) {
+    for (int i = 0; i < DIST_RWLOCK_SLOTS; i++)
+        if (__atomic_load_n(&lock->slots[i].readers, __ATOMIC_SEQ_CST))
+            return 1;
+    return 0;
+}
+
+/**
+ * @brief Initializes a distributed reader-writer lock.
+ *
+ * @param lock A pointer to the lock.
+ * @param prefer_writer Nonzero to stop new readers while a writer waits, zero
+ * to let readers in until the writer gets the lock.
+ * @return 0 on success, or an error number from `pthread_mutex_init`.
+ */
+int dist_rwlock_init(dist_rwlock_t *lock, int prefer_writer) {
+    for (int i = 0; i < DIST_RWLOCK_SLOTS; i++) lock->slots[i].readers = 0;
+    lock->writer = DIST_WRITER_NONE;
+    lock->prefer_writer = prefer_writer;
+    return pthread_mutex_init(&lock->writer_lock, NULL);
+}
+
+/**
+ * @brief Acquires the lock for reading.
+ *
+ * A reader only writes to its own indicator, so readers on different slots
+ * do not contend with each other.
+ *
+ * @param lock A pointer to the lock.
+ */
+void dist_rwlock_rdlock(dist_rwlock_t *lock) {
+    ReaderSlot *slot = reader_slot(lock);
+    for (;;) {
+        __atomic_fetch_add(&slot->readers, 1, __ATOMIC_SEQ_CST);
+        int writer = __atomic_load_n(&lock->writer, __ATOMIC_SEQ_CST);
+        if (writer == DIST_WRITER_NONE ||
+            (writer == DIST_WRITER_WAITING && !lock->prefer_writer))
+            return;
+
+        // Back off and wait for the writer to finish.
+        __atomic_fetch_sub(&slot->readers, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&lock->writer, __ATOMIC_ACQUIRE) ==
+                   DIST_WRITER_ACTIVE ||
+               (lock->prefer_writer &&
+                __atomic_load_n(&lock->writer, __ATOMIC_ACQUIRE) !=
+                    DIST_WRITER_NONE))
+            sched_yield();
+    }
+}
+
+/**
+ * @brief Releases a lock acquired with `dist_rwlock_rdlock`.
+ *
+ * @param lock A pointer to the lock.
+ */
+void dist_rwlock_rdunlock(dist_rwlock_t *lock) {
+    __atomic_fetch_sub(&reader_slot(lock)->readers, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Acquires the lock for writing.
+ *
+ * Writers queue on a mutex, announce themselves and wait for every reader
+ * indicator to drain.
+ *
+ * @param lock A pointer to the lock.
+ */
+void dist_rwlock_wrlock(dist_rwlock_t *lock) {
+    pthread_mutex_lock(&lock->writer_lock);
+    __atomic_store_n(&lock->writer, DIST_WRITER_WAITING, __ATOMIC_SEQ_CST);
+    for (;;) {
+        while (readers_present(lock)) sched_yield();
+
+        // A reader that got in after the scan sees the active writer and
+        // backs off, or we see its indicator and retry.
+        __atomic_store_n(&lock->writer, DIST_WRITER_ACTIVE, __ATOMIC_SEQ_CST);
+        if (!readers_present(lock)) return;
+        __atomic_store_n(&lock->writer, DIST_WRITER_WAITING, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * @brief Releases a lock acquired with `dist_rwlock_wrlock`.
+ *
+ * @param lock A pointer to the lock.
+ */
+void dist_rwlock_wrunlock(dist_rwlock_t *lock) {
+    __atomic_store_n(&lock->writer, DIST_WRITER_NONE, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&lock->writer_lock);
+}
+
+/**
+ * @brief Destroys a lock initialized with `dist_rwlock_init`.
+ *
+ * @param lock A pointer to the lock.
+ */
+void dist_rwlock_destroy(dist_rwlock_t *lock) {
+    pthread_mutex_destroy(&lock->writer_lock);
+}
@@ -0,0 +1,30 @@
+#ifndef DIST_RWLOCK_H
+#define DIST_RWLOCK_H
+
+#include <pthread.h>
+
+// Number of reader indicators per lock. Threads are spread over the slots, so
+// readers on different slots never write to the same cache line.
+#define DIST_RWLOCK_SLOTS 64
+#define DIST_RWLOCK_CACHE_LINE 64
+
+typedef struct {
+    int readers;
+    char pad[DIST_RWLOCK_CACHE_LINE - sizeof(int)];
+} __attribute__((aligned(DIST_RWLOCK_CACHE_LINE))) ReaderSlot;
+
+typedef struct {
+    ReaderSlot slots[DIST_RWLOCK_SLOTS];
+    int writer;         // DIST_WRITER_NONE, _WAITING or _ACTIVE
+    int prefer_writer;  // Readers back off from a waiting writer
+    pthread_mutex_t writer_lock;
+} dist_rwlock_t;
+
+int dist_rwlock_init(dist_rwlock_t *lock, int prefer_writer);
+void dist_rwlock_rdlock(dist_rwlock_t *lock);
+void dist_rwlock_rdunlock(dist_rwlock_t *lock);
+void dist_rwlock_wrlock(dist_rwlock_t *lock);
+void dist_rwlock_wrunlock(dist_rwlock_t *lock);
+void dist_rwlock_destroy(dist_rwlock_t *lock);
+
+#endif
@@ -0,0 +1,341 @@
+#include "hash_map.h"
+
+#include <string.h>
+
+// Marks a bucket of the old table whose entries have moved to the new one.
+#define HASH_MAP_MOVED ((HashEntry *)1)
+
+/**
+ * @brief Hashes a key. The low bits are mixed well, since they select the
+ * bucket.
+ *
+ * @param key The key.
+ * @return The hash of the key.
+ */
+static uint32_t hash_of(uint16_t key) {
+    uint32_t hash = (uint32_t)key * 2654435761u;
+    return hash ^ (hash >> 16);
+}
+
+static HashStripe *stripe_of(HashMap *map, uint32_t hash) {
+    return &map->stripes[hash % HASH_MAP_STRIPES];
+}
+
+/**
+ * @brief Write-locks every stripe, in order, so that no thread is looking at
+ * either table.
+ *
+ * @param map A pointer to the hash map.
+ */
+static void lock_all(HashMap *map) {
+    for (int i = 0; i < HASH_MAP_STRIPES; i++)
+        pthread_rwlock_wrlock(&map->stripes[i].lock);
+}
+
+static void unlock_all(HashMap *map) {
+    for (int i = HASH_MAP_STRIPES - 1; i >= 0; i--)
+        pthread_rwlock_unlock(&map->stripes[i].lock);
+}
+
+/**
+ * @brief Initializes an empty hash map whose entries and buckets are taken
+ * from the memory pool.
+ *
+ * @param map A pointer to the hash map.
+ * @return 0 on success, -1 if the pool has no room for the first buckets.
+ */
+int hash_map_init(HashMap *map) {
+    map->buckets = mem_alloc(HASH_MAP_STRIPES * sizeof(HashEntry *));
+    if (!map->buckets) return -1;
+    memset(map->buckets, 0, HASH_MAP_STRIPES * sizeof(HashEntry *));
+    map->num_buckets = HASH_MAP_STRIPES;
+    for (int i = 0; i < HASH_MAP_STRIPES; i++) {
+        pthread_rwlock_init(&map->stripes[i].lock, NULL);
+        map->stripes[i].migrate_next = 0;
+        map->stripes[i].migrated = 0;
+    }
+    map->old_buckets = NULL;
+    map->old_num_buckets = 0;
+    map->resizing = 0;
+    map->stripes_migrated = 0;
+    map->next_stripe = 0;
+    map->count = 0;
+    return 0;
+}
+
+/**
+ * @brief Moves the entries of a bucket of the old table to the new one. A
+ * bucket splits into two buckets of the same stripe, whose lock the caller
+ * must hold for writing.
+ *
+ * @param map A pointer to the hash map.
+ * @param index The index of the bucket in the old table.
+ */
+static void migrate_bucket(HashMap *map, size_t index) {
+    HashEntry *entry = map->old_buckets[index];
+    if (entry == HASH_MAP_MOVED) return;
+    while (entry) {
+        HashEntry *next = entry->next;
+        HashEntry **bucket =
+            &map->buckets[hash_of(entry->key) & (map->num_buckets - 1)];
+        entry->next = *bucket;
+        *bucket = entry;
+        entry = next;
+    }
+    map->old_buckets[index] = HASH_MAP_MOVED;
+}
+
+/**
+ * @brief Returns the bucket to search for a hash. The caller must hold the
+ * hash's stripe lock.
+ *
+ * @param map A pointer to the hash map.
+ * @param hash The hash of the key.
+ * @return A pointer to the head of the bucket.
+ */
+static HashEntry **bucket_for_read(HashMap *map, uint32_t hash) {
+    if (map->old_buckets) {
+        HashEntry **old = &map->old_buckets[hash & (map->old_num_buckets - 1)];
+        if (*old != HASH_MAP_MOVED) return old;
+    }
+    return &map->buckets[hash & (map->num_buckets - 1)];
+}
+
+/**
+ * @brief Returns the bucket to modify for a hash, moving it to the new table
+ * first if a resize is under way. The caller must hold the hash's stripe lock
+ * for writing.
+ *
+ * @param map A pointer to the hash map.
+ * @param hash The hash of the key.
+ * @return A pointer to the head of the bucket.
+ */
+static HashEntry **bucket_for_write(HashMap *map, uint32_t hash) {
+    if (map->old_buckets)
+        migrate_bucket(map, hash & (map->old_num_buckets - 1));
+    return &map->buckets[hash & (map->num_buckets - 1)];
+}
+
+/**
+ * @brief Starts doubling the table if the map is still over its load factor.
+ * Only the empty new table is set up here; the entries move over during
+ * later writes.
+ *
+ * @param map A pointer to the hash map.
+ * @param num_buckets The bucket count the caller saw over its load factor.
+ */
+static void resize_start(HashMap *map, size_t num_buckets) {
+    // Writes keep landing over the load factor until the running resize
+    // finishes; they leave it to finish instead of building a table each.
+    if (__atomic_load_n(&map->resizing, __ATOMIC_ACQUIRE)) return;
+
+    // The table is allocated before taking the stripes, so other threads
+    // wait only for the swap.
+    HashEntry **buckets = mem_alloc(2 * num_buckets * sizeof(HashEntry *));
+    if (!buckets) return;
+    memset(buckets, 0, 2 * num_buckets * sizeof(HashEntry *));
+
+    lock_all(map);
+    if (!map->old_buckets && map->num_buckets == num_buckets) {
+        map->old_buckets = map->buckets;
+        map->old_num_buckets = num_buckets;
+        map->buckets = buckets;
+        map->num_buckets = 2 * num_buckets;
+        buckets = NULL;
+        for (int i = 0; i < HASH_MAP_STRIPES; i++) {
+            map->stripes[i].migrate_next = i;
+            map->stripes[i].migrated = 0;
+        }
+        map->stripes_migrated = 0;
+        __atomic_store_n(&map->resizing, 1, __ATOMIC_RELEASE);
+    }
+    unlock_all(map);
+
+    // Another writer got there first.
+    if (buckets) mem_free(buckets);
+}
+
+/**
+ * @brief Frees the old table once every bucket has moved.
+ *
+ * @param map A pointer to the hash map.
+ */
+static void resize_finish(HashMap *map) {
+    lock_all(map);
+    HashEntry **old_buckets = map->old_buckets;
+    map->old_buckets = NULL;
+    map->old_num_buckets = 0;
+    __atomic_store_n(&map->resizing, 0, __ATOMIC_RELEASE);
+    unlock_all(map);
+    mem_free(old_buckets);
+}
+
+/**
+ * @brief Moves a few buckets of one stripe to the new table while a resize is
+ * under way. Writers take turns over the stripes, so every stripe drains even
+ * if its own keys are never written.
+ *
+ * @param map A pointer to the hash map.
+ */
+static void migrate_step(HashMap *map) {
+    if (!__atomic_load_n(&map->resizing, __ATOMIC_ACQUIRE)) return;
+
+    unsigned index =
+        __atomic_fetch_add(&map->next_stripe, 1, __ATOMIC_RELAXED) %
+        HASH_MAP_STRIPES;
+    HashStripe *stripe = &map->stripes[index];
+    int finished = 0;
+
+    pthread_rwlock_wrlock(&stripe->lock);
+    if (map->old_buckets && !stripe->migrated) {
+        for (int i = 0; i < HASH_MAP_MIGRATE_STEP &&
+                        stripe->migrate_next < map->old_num_buckets;
+             i++) {
+            migrate_bucket(map, stripe->migrate_next);
+            stripe->migrate_next += HASH_MAP_STRIPES;
+        }
+        if (stripe->migrate_next >= map->old_num_buckets) {
+            stripe->migrated = 1;
+            finished = __atomic_add_fetch(&map->stripes_migrated, 1,
+                                          __ATOMIC_ACQ_REL) == HASH_MAP_STRIPES;
+        }
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+
+    if (finished) resize_finish(map);
+}
+
+/**
+ * @brief Maps a key to a value, replacing the value if the key is present.
+ *
+ * @param map A pointer to the hash map.
+ * @param key The key.
+ * @param value The value.
+ * @return 0 on success, -1 if the pool is out of memory.
+ */
+int hash_map_put(HashMap *map, uint16_t key, void *value) {
+    uint32_t hash = hash_of(key);
+    HashStripe *stripe = stripe_of(map, hash);
+    int added = 0;
+    int result = 0;
+
+    pthread_rwlock_wrlock(&stripe->lock);
+    HashEntry **bucket = bucket_for_write(map, hash);
+    HashEntry *entry = *bucket;
+    while (entry && entry->key != key) entry = entry->next;
+    if (entry) {
+        entry->value = value;
+    } else if ((entry = mem_alloc(sizeof(HashEntry)))) {
+        entry->key = key;
+        entry->value = value;
+        entry->next = *bucket;
+        *bucket = entry;
+        added = 1;
+    } else {
+        result = -1;
+    }
+    size_t num_buckets = map->num_buckets;
+    pthread_rwlock_unlock(&stripe->lock);
+
+    if (added) {
+        size_t count = __atomic_add_fetch(&map->count, 1, __ATOMIC_RELAXED);
+        migrate_step(map);
+        if (count > HASH_MAP_LOAD_FACTOR * num_buckets)
+            resize_start(map, num_buckets);
+    }
+    return result;
+}
+
+/**
+ * @brief Looks up the value of a key.
+ *
+ * @param map A pointer to the hash map.
+ * @param key The key.
+ * @param value Receives the value if the key is present; may be NULL.
+ * @return 1 if the key is present, 0 otherwise.
+ */
+int hash_map_get(HashMap *map, uint16_t key, void **value) {
+    uint32_t hash = hash_of(key);
+    HashStripe *stripe = stripe_of(map, hash);
+
+    pthread_rwlock_rdlock(&stripe->lock);
+    HashEntry *entry = *bucket_for_read(map, hash);
+    while (entry && entry->key != key) entry = entry->next;
+    if (entry && value) *value = entry->value;
+    pthread_rwlock_unlock(&stripe->lock);
+
+    return entry != NULL;
+}
+
+/**
+ * @brief Removes a key and its value.
+ *
+ * @param map A pointer to the hash map.
+ * @param key The key.
+ * @return 1 if the key was present, 0 otherwise.
+ */
+int hash_map_remove(HashMap *map, uint16_t key) {
+    uint32_t hash = hash_of(key);
+    HashStripe *stripe = stripe_of(map, hash);
+
+    pthread_rwlock_wrlock(&stripe->lock);
+    HashEntry **link = bucket_for_write(map, hash);
+    while (*link && (*link)->key != key) link = &(*link)->next;
+    HashEntry *entry = *link;
+    if (entry) *link = entry->next;
+    pthread_rwlock_unlock(&stripe->lock);
+
+    if (!entry) return 0;
+    mem_free(entry);
+    __atomic_sub_fetch(&map->count, 1, __ATOMIC_RELAXED);
+    migrate_step(map);
+    return 1;
+}
+
+/**
+ * @brief Returns the number of keys in the map.
+ *
+ * @param map A pointer to the hash map.
+ * @return The number of keys.
+ */
+size_t hash_map_count(HashMap *map) {
+    return __atomic_load_n(&map->count, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Frees the entries of a table, then the table itself.
+ *
+ * @param buckets The table, or NULL.
+ * @param num_buckets The number of buckets.
+ */
+static void free_table(HashEntry **buckets, size_t num_buckets) {
+    if (!buckets) return;
+    for (size_t i = 0; i < num_buckets; i++) {
+        HashEntry *entry = buckets[i];
+        if (entry == HASH_MAP_MOVED) continue;
+        while (entry) {
+            HashEntry *next = entry->next;
+            mem_free(entry);
+            entry = next;
+        }
+    }
+    mem_free(buckets);
+}
+
+/**
+ * @brief Frees all the entries and buckets of the map, including those still
+ * waiting in the old table of an unfinished resize.
+ *
+ * @param map A pointer to the hash map.
+ */
+void hash_map_cleanup(HashMap *map) {
+    free_table(map->old_buckets, map->old_num_buckets);
+    free_table(map->buckets, map->num_buckets);
+    for (int i = 0; i < HASH_MAP_STRIPES; i++)
+        pthread_rwlock_destroy(&map->stripes[i].lock);
+    map->buckets = NULL;
+    map->old_buckets = NULL;
+    map->num_buckets = 0;
+    map->old_num_buckets = 0;
+    map->count = 0;
+}
@@ -0,0 +1,50 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory_manager.h"
+
+// Stripes of locks over the buckets. The bucket count is always a multiple
+// of it, so a bucket and the two buckets it splits into share a stripe.
+#define HASH_MAP_STRIPES 64
+#define HASH_MAP_CACHE_LINE 64
+#define HASH_MAP_LOAD_FACTOR 2     // Entries per bucket that trigger growth
+#define HASH_MAP_MIGRATE_STEP 4    // Buckets moved per write while resizing
+
+typedef struct HashEntry {
+    struct HashEntry *next;
+    uint16_t key;
+    void *value;
+} HashEntry;
+
+// A lock over every HASH_MAP_STRIPES-th bucket, with the stripe's progress
+// through an ongoing resize.
+typedef struct {
+    pthread_rwlock_t lock;
+    size_t migrate_next;  // Next old bucket of this stripe to move
+    int migrated;         // Whether all old buckets of this stripe moved
+} __attribute__((aligned(HASH_MAP_CACHE_LINE))) HashStripe;
+
+typedef struct {
+    HashStripe stripes[HASH_MAP_STRIPES];
+    HashEntry **buckets;
+    size_t num_buckets;
+    HashEntry **old_buckets;  // Table being drained by a resize, or NULL
+    size_t old_num_buckets;
+    int resizing;
+    int stripes_migrated;
+    unsigned next_stripe;  // Stripe the next migration step helps
+    size_t count;
+} HashMap;
+
+int hash_map_init(HashMap *map);
+int hash_map_put(HashMap *map, uint16_t key, void *value);
+int hash_map_get(HashMap *map, uint16_t key, void **value);
+int hash_map_remove(HashMap *map, uint16_t key);
+size_t hash_map_count(HashMap *map);
+void hash_map_cleanup(HashMap *map);
+
+#endif
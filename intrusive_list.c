@@ -0,0 +1,226 @@
+#include "intrusive_list.h"
+
+/**
+ * @brief Links `link` between two adjacent links. The caller must hold the
+ * list's lock for writing.
+ *
+ * @param link The link to insert.
+ * @param prev The link that will precede it.
+ * @param next The link that will follow it.
+ */
+static void link_between(ListLink *link, ListLink *prev, ListLink *next) {
+    link->prev = prev;
+    link->next = next;
+    prev->next = link;
+    next->prev = link;
+}
+
+/**
+ * @brief Initializes an empty intrusive list.
+ *
+ * @param list A pointer to the list.
+ */
+void ilist_init(IntrusiveList *list) {
+    list->head.next = &list->head;
+    list->head.prev = &list->head;
+    list->count = 0;
+    pthread_rwlock_init(&list->lock, NULL);
+}
+
+/**
+ * @brief Links an object at the front of the list. The caller must hold the
+ * list's lock for writing.
+ *
+ * @param list A pointer to the list.
+ * @param link The link embedded in the object, not on any list.
+ */
+void ilist_push_front_no_lock(IntrusiveList *list, ListLink *link) {
+    link_between(link, &list->head, list->head.next);
+    list->count++;
+}
+
+/**
+ * @brief Links an object at the back of the list. The caller must hold the
+ * list's lock for writing.
+ *
+ * @param list A pointer to the list.
+ * @param link The link embedded in the object, not on any list.
+ */
+void ilist_push_back_no_lock(IntrusiveList *list, ListLink *link) {
+    link_between(link, list->head.prev, &list->head);
+    list->count++;
+}
+
+/**
+ * @brief Links an object right after another one on the list. The caller
+ * must hold the list's lock for writing.
+ *
+ * @param list A pointer to the list.
+ * @param pos A link already on the list.
+ * @param link The link embedded in the object, not on any list.
+ */
+void ilist_insert_after_no_lock(IntrusiveList *list, ListLink *pos,
+                                ListLink *link) {
+    link_between(link, pos, pos->next);
+    list->count++;
+}
+
+/**
+ * @brief Unlinks an object from the list in O(1). The caller must hold the
+ * list's lock for writing.
+ *
+ * @param list A pointer to the list.
+ * @param link A link on the list.
+ */
+void ilist_remove_no_lock(IntrusiveList *list, ListLink *link) {
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->next = link->prev = NULL;
+    list->count--;
+}
+
+/**
+ * @brief Unlinks the first object of the list. The caller must hold the
+ * list's lock for writing.
+ *
+ * @param list A pointer to the list.
+ * @return The unlinked link, or NULL if the list is empty.
+ */
+ListLink *ilist_pop_front_no_lock(IntrusiveList *list) {
+    ListLink *link = list->head.next;
+    if (link == &list->head) return NULL;
+    ilist_remove_no_lock(list, link);
+    return link;
+}
+
+/**
+ * @brief Links an object at the front of the list.
+ *
+ * @param list A pointer to the list.
+ * @param link The link embedded in the object, not on any list.
+ */
+void ilist_push_front(IntrusiveList *list, ListLink *link) {
+    pthread_rwlock_wrlock(&list->lock);
+    ilist_push_front_no_lock(list, link);
+    pthread_rwlock_unlock(&list->lock);
+}
+
+/**
+ * @brief Links an object at the back of the list.
+ *
+ * @param list A pointer to the list.
+ * @param link The link embedded in the object, not on any list.
+ */
+void ilist_push_back(IntrusiveList *list, ListLink *link) {
+    pthread_rwlock_wrlock(&list->lock);
+    ilist_push_back_no_lock(list, link);
+    pthread_rwlock_unlock(&list->lock);
+}
+
+/**
+ * @brief Links an object right after another one on the list.
+ *
+ * @param list A pointer to the list.
+ * @param pos A link already on the list.
+ * @param link The link embedded in the object, not on any list.
+ */
+void ilist_insert_after(IntrusiveList *list, ListLink *pos, ListLink *link) {
+    pthread_rwlock_wrlock(&list->lock);
+    ilist_insert_after_no_lock(list, pos, link);
+    pthread_rwlock_unlock(&list->lock);
+}
+
+/**
+ * @brief Unlinks an object from the list in O(1). The object itself is left
+ * to the caller.
+ *
+ * @param list A pointer to the list.
+ * @param link A link on the list.
+ */
+void ilist_remove(IntrusiveList *list, ListLink *link) {
+    pthread_rwlock_wrlock(&list->lock);
+    ilist_remove_no_lock(list, link);
+    pthread_rwlock_unlock(&list->lock);
+}
+
+/**
+ * @brief Unlinks the first object of the list.
+ *
+ * @param list A pointer to the list.
+ * @return The unlinked link, or NULL if the list is empty.
+ */
+ListLink *ilist_pop_front(IntrusiveList *list) {
+    pthread_rwlock_wrlock(&list->lock);
+    ListLink *link = ilist_pop_front_no_lock(list);
+    pthread_rwlock_unlock(&list->lock);
+    return link;
+}
+
+/**
+ * @brief Returns the first link for which `match` returns nonzero.
+ *
+ * @param list A pointer to the list.
+ * @param match The predicate, called under the list's read lock.
+ * @param key An argument passed through to `match`.
+ * @return The matching link, or NULL if there is none.
+ */
+ListLink *ilist_find(IntrusiveList *list,
+                     int (*match)(const ListLink *link, const void *key),
+                     const void *key) {
+    ListLink *link;
+    pthread_rwlock_rdlock(&list->lock);
+    ilist_for_each(list, link) {
+        if (match(link, key)) {
+            pthread_rwlock_unlock(&list->lock);
+            return link;
+        }
+    }
+    pthread_rwlock_unlock(&list->lock);
+    return NULL;
+}
+
+/**
+ * @brief Returns the number of objects on the list.
+ *
+ * @param list A pointer to the list.
+ * @return The number of linked objects.
+ */
+size_t ilist_count(IntrusiveList *list) {
+    pthread_rwlock_rdlock(&list->lock);
+    size_t count = list->count;
+    pthread_rwlock_unlock(&list->lock);
+    return count;
+}
+
+/**
+ * @brief Locks the list for reading, e.g. around `ilist_for_each`.
+ *
+ * @param list A pointer to the list.
+ */
+void ilist_rdlock(IntrusiveList *list) { pthread_rwlock_rdlock(&list->lock); }
+
+/**
+ * @brief Locks the list for writing, e.g. to combine several `ilist_*_no_lock`
+ * calls into one atomic update.
+ *
+ * @param list A pointer to the list.
+ */
+void ilist_wrlock(IntrusiveList *list) { pthread_rwlock_wrlock(&list->lock); }
+
+/**
+ * @brief Releases a lock taken with `ilist_rdlock` or `ilist_wrlock`.
+ *
+ * @param list A pointer to the list.
+ */
+void ilist_unlock(IntrusiveList *list) { pthread_rwlock_unlock(&list->lock); }
+
+/**
+ * @brief Destroys the list. Linked objects are not touched.
+ *
+ * @param list A pointer to the list.
+ */
+void ilist_destroy(IntrusiveList *list) {
+    list->head.next = list->head.prev = &list->head;
+    list->count = 0;
+    pthread_rwlock_destroy(&list->lock);
+}
@@ -0,0 +1,66 @@
+#ifndef INTRUSIVE_LIST_H
+#define INTRUSIVE_LIST_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+// Returns the object of type `type` whose field `member` is at `ptr`.
+#ifndef container_of
+#define container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+// Returns the object embedding the given link.
+#define ilist_entry(link, type, member) container_of(link, type, member)
+
+// Iterates over the links of a list. The caller must hold the list's lock.
+#define ilist_for_each(list, link) \
+    for ((link) = (list)->head.next; (link) != &(list)->head; \
+         (link) = (link)->next)
+
+// Like ilist_for_each, but `link` may be unlinked with ilist_remove_no_lock
+// inside the loop; `tmp` holds the next link.
+#define ilist_for_each_safe(list, link, tmp)                       \
+    for ((link) = (list)->head.next, (tmp) = (link)->next;         \
+         (link) != &(list)->head; (link) = (tmp), (tmp) = (link)->next)
+
+// Link field embedded in the caller's own objects.
+typedef struct ListLink {
+    struct ListLink *next;
+    struct ListLink *prev;
+} ListLink;
+
+// A circular doubly linked list of embedded links around a sentinel. Linking
+// and unlinking never allocate, and any linked object is removed in O(1).
+typedef struct {
+    ListLink head;
+    size_t count;
+    pthread_rwlock_t lock;
+} IntrusiveList;
+
+void ilist_init(IntrusiveList *list);
+void ilist_push_front(IntrusiveList *list, ListLink *link);
+void ilist_push_back(IntrusiveList *list, ListLink *link);
+void ilist_insert_after(IntrusiveList *list, ListLink *pos, ListLink *link);
+void ilist_remove(IntrusiveList *list, ListLink *link);
+ListLink *ilist_pop_front(IntrusiveList *list);
+ListLink *ilist_find(IntrusiveList *list,
+                     int (*match)(const ListLink *link, const void *key),
+                     const void *key);
+size_t ilist_count(IntrusiveList *list);
+
+// Unlocked variants of the mutators above, for use between ilist_wrlock and
+// ilist_unlock.
+void ilist_push_front_no_lock(IntrusiveList *list, ListLink *link);
+void ilist_push_back_no_lock(IntrusiveList *list, ListLink *link);
+void ilist_insert_after_no_lock(IntrusiveList *list, ListLink *pos,
+                                ListLink *link);
+void ilist_remove_no_lock(IntrusiveList *list, ListLink *link);
+ListLink *ilist_pop_front_no_lock(IntrusiveList *list);
+
+void ilist_rdlock(IntrusiveList *list);
+void ilist_wrlock(IntrusiveList *list);
+void ilist_unlock(IntrusiveList *list);
+void ilist_destroy(IntrusiveList *list);
+
+#endif
@@ -1,172 +1,1612 @@
 #include "linked_list.h"
 
+#include "dist_rwlock.h"
+#include "rcu.h"
 
-pthread_rwlock_t list_lock;
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On-disk list layout: a header followed by `count` packed uint16_t payloads.
+#define LIST_FILE_MAGIC 0x5453494Cu  // "LIST"
+#define LIST_FILE_VERSION 1
+
+// Upper bound on the number of threads in the traversal worker pool.
+#define LIST_MAX_WORKERS 64
+
+// Request slots for combining mode. Threads beyond this many share slots.
+#define LIST_COMBINE_SLOTS 64
+#define LIST_COMBINE_CACHE_LINE 64
+
+// States of a combining slot.
+#define LIST_COMBINE_FREE 0
+#define LIST_COMBINE_CLAIMED 1  // The owner is filling in a request
+#define LIST_COMBINE_PENDING 2  // Waiting for a combiner
+#define LIST_COMBINE_DONE 3     // Applied; the owner may return
+
+// Nodes carry no lock of their own: every list operation serializes on
+// `list_lock`, so a plain node is 16 bytes and four share a cache line.
+#if !defined(LIST_DOUBLY_LINKED) && !defined(LIST_JUMP_POINTERS)
+_Static_assert(sizeof(Node) == 16, "Node should stay 16 bytes");
+#endif
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+} ListFileHeader;
+
+// A traversal split into segments and shared between the caller and the
+// worker pool. Segment `i` runs from `starts[i]` up to `starts[i + 1]`.
+typedef struct ListJob {
+    void (*run)(struct ListJob *job, size_t segment, Node *start, Node *end);
+    Node **starts;
+    size_t count;
+    size_t next;  // Next unclaimed segment, claimed atomically
+
+    uint16_t data;
+    size_t found_segment;  // Lowest segment with a match so far
+    Node **found;
+    uint64_t *partials;
+    list_reduce_fn fn;
+    uint64_t identity;
+    list_compare_fn cmp;
+} ListJob;
+
+// A list_insert or list_delete published for the combiner.
+typedef struct {
+    int state;  // LIST_COMBINE_*
+    int op;     // LIST_OP_INSERT or LIST_OP_DELETE
+    uint16_t data;
+    Node **head;
+    Node *node;  // The node to append (LIST_OP_INSERT)
+} __attribute__((aligned(LIST_COMBINE_CACHE_LINE))) CombineSlot;
+
+dist_rwlock_t list_lock;
+
+// In RCU mode, list_search, list_count_nodes and list_reduce traverse without
+// taking list_lock, and unlinked nodes are freed after a grace period.
+static int rcu_mode;
+
+// Bumped by every release of list_lock after a write, so a reader can tell
+// whether what it saw under the read lock still holds.
+static unsigned long list_generation;
+
+// Nonzero while a writer that relinks nodes wholesale (list_sort) needs the
+// RCU readers to take list_lock like everyone else.
+static int rcu_readers_excluded;
+
+// How list_search reorders the list on a hit (LIST_ORGANIZE_*).
+static int organize_mode;
+
+// In combining mode, list_insert and list_delete publish their request to a
+// slot, and whichever writer holds `combine_lock` applies every pending
+// request under one acquisition of list_lock.
+static int combining_mode;
+static CombineSlot combine_slots[LIST_COMBINE_SLOTS];
+static pthread_mutex_t combine_lock = PTHREAD_MUTEX_INITIALIZER;
+static int combine_next_slot;
+static __thread int combine_slot = -1;
+
+// Segment directory used to split traversals across the worker pool. Every
+// anchor starts a segment that runs up to the next anchor, and the first
+// segment starts at the head. Anchors are kept valid by the write operations;
+// insertions off the tail only unbalance the segments until the next rebuild.
+static Node **segment_head;  // The list the directory describes
+static Node **segments;
+static size_t segment_count;
+static size_t segment_capacity;
+static size_t segment_nodes;     // Approximate number of nodes in the list
+static size_t segment_drift;     // Nodes inserted off the tail since rebuild
+static size_t segment_tail_run;  // Nodes appended since the last anchor
+static int segment_stale;        // Chains moved in or out since rebuild
+static size_t segment_length = LIST_SEGMENT_LENGTH;
+static pthread_mutex_t segment_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Worker pool, started on the first parallel traversal.
+static int pool_size;  // Number of workers including the calling thread
+static pthread_t pool_threads[LIST_MAX_WORKERS];
+static int pool_started;
+static int pool_stop;
+static int pool_active;
+static unsigned long pool_generation;
+static ListJob *pool_job;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_run_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+
+// Incremental relinearization: the last node copied by the previous step (NULL
+// to start a new pass at the head) and the optional background thread.
+static Node *relinearize_cursor;
+static Node **relinearize_cursor_head;
+static pthread_t relinearize_thread;
+static int relinearize_running;
+static Node **relinearize_list;
+static size_t relinearize_nodes_per_step;
+static unsigned int relinearize_interval_us;
+
+/**
+ * @brief Stores a link that lock-free readers may follow. The release store
+ * makes the node it points to fully initialized before it becomes reachable.
+ *
+ * @param link The link to update.
+ * @param node The node to link to.
+ */
+static inline void link_publish(Node **link, Node *node) {
+    __atomic_store_n(link, node, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Loads a link that a writer may be updating concurrently.
+ *
+ * @param link The link to follow.
+ * @return The node the link points to.
+ */
+static inline Node *link_follow(Node **link) {
+    return __atomic_load_n(link, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Frees an unlinked node, after a grace period in RCU mode.
+ *
+ * @param node The node to free.
+ */
+static void list_free_node(Node *node) {
+    if (rcu_mode)
+        rcu_defer_free(node, mem_free);
+    else
+        mem_free(node);
+}
+
+/**
+ * @brief Releases list_lock after a write, then runs any deferred frees that
+ * have built up, so the grace period is waited out without the lock held.
+ */
+static void list_wrunlock() {
+    list_generation++;
+    dist_rwlock_wrunlock(&list_lock);
+    if (rcu_mode) rcu_flush();
+}
+
+/**
+ * @brief Enters a lock-free read-side section, unless a writer currently
+ * excludes RCU readers.
+ *
+ * @return 1 inside a read-side section, 0 if the caller must take list_lock
+ * for reading instead.
+ */
+static int list_rcu_enter() {
+    rcu_read_lock();
+    if (!__atomic_load_n(&rcu_readers_excluded, __ATOMIC_SEQ_CST)) return 1;
+    rcu_read_unlock();
+    return 0;
+}
+
+/**
+ * @brief Takes list_lock for writing with RCU readers shut out as well: new
+ * readers fall back to list_lock, and the ones already running are waited
+ * for. Released with list_wrunlock_exclusive.
+ */
+static void list_wrlock_exclusive() {
+    __atomic_add_fetch(&rcu_readers_excluded, 1, __ATOMIC_SEQ_CST);
+    if (rcu_mode) synchronize_rcu();
+    dist_rwlock_wrlock(&list_lock);
+}
+
+static void list_wrunlock_exclusive() {
+    list_wrunlock();
+    __atomic_sub_fetch(&rcu_readers_excluded, 1, __ATOMIC_SEQ_CST);
+}
+
+#ifdef LIST_DOUBLY_LINKED
+#define node_get_prev(node) ((node)->prev)
+#define node_set_prev(node, value) ((node)->prev = (value))
+#else
+#define node_get_prev(node) NULL
+#define node_set_prev(node, value) ((void)(value))
+#endif
+
+#ifdef LIST_JUMP_POINTERS
+// Jump links may be read by lock-free readers, and may point to freed nodes:
+// a prefetch never faults.
+#define node_get_jump(node) __atomic_load_n(&(node)->jump, __ATOMIC_RELAXED)
+#define node_set_jump(node, value) \
+    __atomic_store_n(&(node)->jump, (value), __ATOMIC_RELAXED)
+#define node_prefetch(node) __builtin_prefetch(node_get_jump(node))
+#else
+#define node_get_jump(node) NULL
+#define node_set_jump(node, value) ((void)(value))
+#define node_prefetch(node) ((void)0)
+#endif
+
+// Recovers the node whose `next` field is the given link.
+#define node_of_link(link) \
+    ((Node *)((char *)(link) - offsetof(Node, next)))
+
+/**
+ * @brief Finds the link pointing to a node: the head itself or the `next`
+ * field of its predecessor. The caller must hold `list_lock` for writing.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param node The node to look for.
+ * @return The link, or NULL if the node is not in the list.
+ */
+static Node **list_link_to(Node **head, Node *node) {
+    if (*head == node) return head;
+#ifdef LIST_DOUBLY_LINKED
+    return node->prev ? &node->prev->next : NULL;
+#else
+    Node *current = *head;
+    while (current && current->next != node) current = current->next;
+    return current ? &current->next : NULL;
+#endif
+}
+
+/**
+ * @brief Points every node's jump link exactly LIST_JUMP_DISTANCE nodes
+ * ahead, or to NULL near the tail. The caller must exclude writers.
+ *
+ * @param first The first node of the list.
+ */
+static void jump_rebuild(Node *first) {
+#ifdef LIST_JUMP_POINTERS
+    Node *window[LIST_JUMP_DISTANCE];
+    size_t position = 0;
+    for (Node *current = first; current; current = current->next, position++) {
+        size_t slot = position % LIST_JUMP_DISTANCE;
+        if (position >= LIST_JUMP_DISTANCE) node_set_jump(window[slot], current);
+        node_set_jump(current, NULL);
+        window[slot] = current;
+    }
+#endif
+}
+
+/**
+ * @brief Adds an anchor to the end of the segment directory.
+ *
+ * @param node The node starting the new segment.
+ */
+static void segment_add_anchor(Node *node) {
+    if (segment_count == segment_capacity) {
+        size_t capacity = segment_capacity ? segment_capacity * 2 : 16;
+        Node **grown = realloc(segments, capacity * sizeof(Node *));
+        if (!grown) return;
+        segments = grown;
+        segment_capacity = capacity;
+    }
+    node->flags |= NODE_SEGMENT_ANCHOR;
+    segments[segment_count++] = node;
+}
+
+/**
+ * @brief Rebuilds the segment directory with evenly sized segments.
+ *
+ * The caller must exclude writers.
+ *
+ * @param first The first node of the list.
+ */
+static void segment_rebuild(Node *first) {
+    segment_count = 0;
+    size_t position = 0;
+    for (Node *current = first; current; current = current->next, position++) {
+        current->flags &= ~NODE_SEGMENT_ANCHOR;
+        if (position > 0 && position % segment_length == 0)
+            segment_add_anchor(current);
+    }
+    segment_nodes = position;
+    segment_drift = 0;
+    segment_tail_run = position % segment_length;
+    segment_stale = 0;
+}
+
+/**
+ * @brief Drops the segment directory after chains moved in or out of the list
+ * it describes, so that the next parallel traversal rebuilds it.
+ *
+ * @param a A double pointer to the head of one list involved.
+ * @param b A double pointer to the head of the other list involved.
+ */
+static void segment_invalidate(Node **a, Node **b) {
+    if (a != segment_head && b != segment_head) return;
+    for (size_t i = 0; i < segment_count; i++)
+        segments[i]->flags &= ~NODE_SEGMENT_ANCHOR;
+    segment_count = 0;
+    segment_stale = 1;
+}
+
+/**
+ * @brief Records a node appended to the tail of the list.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param node The appended node.
+ */
+static void segment_note_append(Node **head, Node *node) {
+    if (head != segment_head) return;
+    segment_nodes++;
+    if (++segment_tail_run >= segment_length && node != *head) {
+        segment_add_anchor(node);
+        segment_tail_run = 0;
+    }
+}
+
+/**
+ * @brief Records a node inserted anywhere but the tail of the list.
+ *
+ * list_insert_after cannot tell which list its node joins and passes NULL.
+ * Such inserts only count as drift, so at worst they bring the next rebuild
+ * forward.
+ *
+ * @param head A double pointer to the head of the linked list, or NULL if
+ * unknown.
+ */
+static void segment_note_insert(Node **head) {
+    if (head && head != segment_head) return;
+    if (head) segment_nodes++;
+    segment_drift++;
+}
+
+/**
+ * @brief Records a node about to be unlinked from the list, moving its anchor
+ * to the next node if it starts a segment.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param node The node being unlinked.
+ */
+static void segment_note_delete(Node **head, Node *node) {
+    if (head != segment_head) return;
+    if (segment_nodes > 0) segment_nodes--;
+    if (!(node->flags & NODE_SEGMENT_ANCHOR)) return;
+
+    size_t i = 0;
+    while (i < segment_count && segments[i] != node) i++;
+    if (i == segment_count) return;
+
+    Node *next = node->next;
+    if (next && !(next->flags & NODE_SEGMENT_ANCHOR)) {
+        next->flags |= NODE_SEGMENT_ANCHOR;
+        segments[i] = next;
+    } else {
+        memmove(&segments[i], &segments[i + 1],
+                (segment_count - i - 1) * sizeof(Node *));
+        segment_count--;
+    }
+}
+
+/**
+ * @brief Claims and runs segments of a job until none are left.
+ *
+ * @param job The job to work on.
+ */
+static void list_job_drain(ListJob *job) {
+    size_t segment;
+    while ((segment = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) <
+           job->count) {
+        Node *end = segment + 1 < job->count ? job->starts[segment + 1] : NULL;
+        job->run(job, segment, job->starts[segment], end);
+    }
+}
+
+static void *list_worker(void *arg) {
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (pool_generation == seen && !pool_stop)
+            pthread_cond_wait(&pool_wake, &pool_lock);
+        if (pool_stop) break;
+        seen = pool_generation;
+
+        // The job is gone if the caller finished it before we woke up.
+        ListJob *job = pool_job;
+        if (!job) continue;
+        pool_active++;
+        pthread_mutex_unlock(&pool_lock);
+
+        list_job_drain(job);
+
+        pthread_mutex_lock(&pool_lock);
+        if (--pool_active == 0) pthread_cond_broadcast(&pool_done);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+/**
+ * @brief Stops and joins the worker pool.
+ */
+static void list_pool_stop() {
+    pthread_mutex_lock(&pool_run_lock);
+    if (pool_started) {
+        pthread_mutex_lock(&pool_lock);
+        pool_stop = 1;
+        pthread_cond_broadcast(&pool_wake);
+        pthread_mutex_unlock(&pool_lock);
+
+        for (int i = 0; i < pool_started; i++)
+            pthread_join(pool_threads[i], NULL);
+        pool_started = 0;
+        pool_stop = 0;
+    }
+    pthread_mutex_unlock(&pool_run_lock);
+}
+
+/**
+ * @brief Frees the segment and result arrays of a job.
+ *
+ * @param job The job to release.
+ */
+static void list_job_release(ListJob *job) {
+    free(job->starts);
+    free(job->found);
+    free(job->partials);
+    job->starts = NULL;
+    job->found = NULL;
+    job->partials = NULL;
+}
+
+static void list_job_dispatch(ListJob *job);
+
+/**
+ * @brief Splits a traversal over the segment directory and runs it on the
+ * worker pool. The caller must hold `list_lock` for reading, and release the
+ * job with `list_job_release` after reading its results.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param job The job to run, with its operation fields filled in.
+ * @return 1 if the job ran, 0 if the caller should traverse sequentially.
+ */
+static int list_run_parallel(Node **head, ListJob *job) {
+    if (head != segment_head || pool_size < 2 || !*head) return 0;
+
+    // Split the list using a snapshot of the directory.
+    pthread_mutex_lock(&segment_lock);
+    if (segment_stale || (segment_drift > segment_nodes / 2 &&
+                          segment_nodes >= 2 * segment_length))
+        segment_rebuild(*head);
+    job->count = segment_count + 1;
+    if (segment_count) {
+        job->starts = malloc(job->count * sizeof(Node *));
+        job->found = calloc(job->count, sizeof(Node *));
+        job->partials = calloc(job->count, sizeof(uint64_t));
+    }
+    if (job->starts) {
+        job->starts[0] = *head;
+        memcpy(&job->starts[1], segments, segment_count * sizeof(Node *));
+    }
+    pthread_mutex_unlock(&segment_lock);
+
+    if (!job->starts || !job->found || !job->partials) {
+        list_job_release(job);
+        return 0;
+    }
+    list_job_dispatch(job);
+    return 1;
+}
+
+/**
+ * @brief Runs every segment of a job, on the worker pool if it is free.
+ *
+ * @param job The job to run.
+ */
+static void list_job_dispatch(ListJob *job) {
+    // Only one job uses the pool at a time, the others run alone.
+    if (pthread_mutex_trylock(&pool_run_lock) != 0) {
+        list_job_drain(job);
+        return;
+    }
+    while (pool_started < pool_size - 1) {
+        if (pthread_create(&pool_threads[pool_started], NULL, list_worker,
+                           NULL) != 0)
+            break;
+        pool_started++;
+    }
+
+    job->next = 0;
+    pthread_mutex_lock(&pool_lock);
+    pool_job = job;
+    pool_generation++;
+    pthread_cond_broadcast(&pool_wake);
+    pthread_mutex_unlock(&pool_lock);
+
+    list_job_drain(job);
+
+    // Every segment is claimed, so the job is done once no worker is active.
+    pthread_mutex_lock(&pool_lock);
+    while (pool_active > 0) pthread_cond_wait(&pool_done, &pool_lock);
+    pool_job = NULL;
+    pthread_mutex_unlock(&pool_lock);
+
+    pthread_mutex_unlock(&pool_run_lock);
+}
+
+/**
+ * @brief Initializes the linked list.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param size The size in bytes to allocate.
+ */
+void list_init(Node **head, size_t size) {
+    mem_init(size);
+    *head = NULL;
+    // Writers go first, so a steady stream of readers cannot starve them.
+    dist_rwlock_init(&list_lock, 1);
+
+    segment_head = head;
+    segment_count = 0;
+    segment_nodes = 0;
+    segment_drift = 0;
+    segment_tail_run = 0;
+    segment_stale = 0;
+    if (pool_size == 0) list_set_parallelism(0, 0);
+}
+
+/**
+ * @brief Sets how traversals of long lists are split across threads. Must not
+ * run concurrently with other list operations.
+ *
+ * @param num_workers The number of threads working on a traversal, including
+ * the caller (0 for the number of online processors, 1 to disable).
+ * @param nodes_per_segment The number of nodes per segment (0 for the
+ * default).
+ */
+void list_set_parallelism(int num_workers, size_t nodes_per_segment) {
+    if (num_workers <= 0) num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_workers < 1) num_workers = 1;
+    if (num_workers > LIST_MAX_WORKERS) num_workers = LIST_MAX_WORKERS;
+
+    list_pool_stop();
+    pool_size = num_workers;
+
+    pthread_mutex_lock(&segment_lock);
+    segment_length = nodes_per_segment ? nodes_per_segment : LIST_SEGMENT_LENGTH;
+    segment_drift = segment_nodes + 1;  // Rebuild on the next traversal
+    pthread_mutex_unlock(&segment_lock);
+}
+
+/**
+ * @brief Switches the lock-free RCU read path on or off. Must not run
+ * concurrently with other list operations.
+ *
+ * In RCU mode list_search, list_count_nodes and list_reduce run without
+ * acquiring any lock or performing atomic read-modify-writes, and deleted
+ * nodes are freed in batches once a grace period has passed. Writers still
+ * serialize on list_lock.
+ *
+ * @param enabled Nonzero to enable RCU mode, zero to disable it.
+ */
+void list_set_rcu(int enabled) {
+    if (!enabled) rcu_barrier();
+    rcu_mode = enabled;
+}
+
+/**
+ * @brief Makes list_search move the nodes it finds towards the head, so that
+ * skewed lookups find hot values in a few hops. Must not run concurrently
+ * with other list operations.
+ *
+ * Moving a node takes `list_lock` for writing. Nodes stay in place in RCU
+ * mode, whose lock-free readers could otherwise skip a moving node.
+ *
+ * @param mode LIST_ORGANIZE_MOVE_TO_FRONT to move a found node to the head,
+ * LIST_ORGANIZE_TRANSPOSE to swap it with its predecessor, or
+ * LIST_ORGANIZE_NONE to leave the order alone.
+ */
+void list_set_self_organizing(int mode) { organize_mode = mode; }
+
+/**
+ * @brief Switches flat combining of list_insert and list_delete on or off.
+ * Must not run concurrently with other list operations.
+ *
+ * In combining mode a writer publishes its request and one thread at a time
+ * applies all pending requests in a single traversal: deletes unlink their
+ * nodes on the way down the list, and the appends of the round are linked
+ * in together at the tail it ends on. Appended nodes get no jump links until
+ * list_update_jumps().
+ *
+ * @param enabled Nonzero to enable combining, zero to disable it.
+ */
+void list_set_combining(int enabled) { combining_mode = enabled; }
+
+static void list_combine(Node **head, int op, uint16_t data, Node *node);
+
+/**
+ * @brief Inserts the specified data at the end of the linked list.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param data The data to insert into the linked list.
+ */
+void list_insert(Node **head, uint16_t data) {
+
+    Node *new_node = mem_alloc(sizeof(Node));
+    if (!new_node) {
+        // printf_red("Memory allocation for insertion failed!\n");
+        return;
+    }
+
+    new_node->data = data;
+    new_node->flags = 0;
+    new_node->next = NULL;
+    node_set_jump(new_node, NULL);
+
+    if (combining_mode) {
+        list_combine(head, LIST_OP_INSERT, data, new_node);
+        return;
+    }
+
+    dist_rwlock_wrlock(&list_lock);
+
+    if (*head == NULL) {
+        node_set_prev(new_node, NULL);
+        link_publish(head, new_node);
+    } else {
+        Node *current = *head;
+#ifdef LIST_JUMP_POINTERS
+        // Trail the walk by the jump distance to find who should jump here.
+        Node *behind = *head;
+        size_t position = 0;
+        while (current->next != NULL) {
+            current = current->next;
+            if (++position >= LIST_JUMP_DISTANCE) behind = behind->next;
+        }
+        if (position + 1 >= LIST_JUMP_DISTANCE) node_set_jump(behind, new_node);
+#else
+        while (current->next != NULL) current = current->next;
+#endif
+        node_set_prev(new_node, current);
+        link_publish(&current->next, new_node);
+    }
+    segment_note_append(head, new_node);
+
+    list_wrunlock();
+}
+
+/**
+ * @brief Inserts the specified data after the given node.
+ *
+ * @param prev_node A pointer to the node to insert data after.
+ * @param data The data to insert into the linked list.
+ */
+void list_insert_after(Node *prev_node, uint16_t data) {
+    if (!prev_node) {
+        // printf_red("Previous node is null!\n");
+        return;
+    }
+
+    // Place the node next to its neighbour to keep the chain clustered.
+    Node *new_node = mem_alloc_near(prev_node, sizeof(Node));
+    if (!new_node) {
+        // printf_red("Memory allocation for insertion after failed!\n");
+        return;
+    }
+    new_node->data = data;
+    new_node->flags = 0;
+
+    dist_rwlock_wrlock(&list_lock);
+
+    // Borrow the neighbour's jump link: it lands one node short.
+    node_set_jump(new_node, node_get_jump(prev_node));
+    Node *next_node = prev_node->next;
+    new_node->next = next_node;
+    node_set_prev(new_node, prev_node);
+    if (next_node) node_set_prev(next_node, new_node);
+    link_publish(&prev_node->next, new_node);
+    segment_note_insert(NULL);
+
+    list_wrunlock();
+}
+
+/**
+ * @brief Inserts the specified data before the given node.
+ *
+ * With LIST_DOUBLY_LINKED the predecessor is read from `next_node->prev` in
+ * O(1); otherwise it is found by walking from the head.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param prev_node A pointer to the node to insert data before.
+ * @param data The data to insert into the linked list.
+ */
+void list_insert_before(Node **head, Node *next_node, uint16_t data) {
+    if (*head == NULL || !next_node) return;
+
+    Node *new_node = mem_alloc_near(next_node, sizeof(Node));
+    if (!new_node) {
+        // printf_red("Memory allocation for insertion before failed!\n");
+        return;
+    }
+
+    new_node->data = data;
+    new_node->flags = 0;
+    new_node->next = next_node;
+
+    dist_rwlock_wrlock(&list_lock);
+
+    Node **link = list_link_to(head, next_node);
+    if (!link) {
+        // The node is not in this list.
+        list_wrunlock();
+        mem_free(new_node);
+        return;
+    }
+    node_set_prev(new_node, link == head ? NULL : node_of_link(link));
+    node_set_prev(next_node, new_node);
+    node_set_jump(new_node, node_get_jump(next_node));
+    link_publish(link, new_node);
+    segment_note_insert(head);
+
+    list_wrunlock();
+}
+
+/**
+ * @brief Unlinks a node without freeing it. The caller must hold `list_lock`
+ * for writing.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param link The link pointing to the node (the head or a `next` field).
+ * @param node The node to unlink.
+ */
+static void list_detach(Node **head, Node **link, Node *node) {
+    if (node == relinearize_cursor) relinearize_cursor = NULL;
+    segment_note_delete(head, node);
+    if (node->next) node_set_prev(node->next, node_get_prev(node));
+    link_publish(link, node->next);
+}
+
+/**
+ * @brief Links a detached node in at the given link. The caller must hold
+ * `list_lock` for writing.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param link The link to insert at (the head or a `next` field).
+ * @param prev The node owning `link`, or NULL if `link` is the head.
+ * @param node The node to link in.
+ */
+static void list_attach(Node **head, Node **link, Node *prev, Node *node) {
+    Node *next = *link;
+    node->next = next;
+    node_set_prev(node, prev);
+    if (next) {
+        node_set_prev(next, node);
+        node_set_jump(node, node_get_jump(next));
+    }
+    link_publish(link, node);
+    segment_note_insert(head);
+}
+
+/**
+ * @brief Unlinks a node and frees it. The caller must hold `list_lock` for
+ * writing.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param link The link pointing to the node (the head or a `next` field).
+ * @param node The node to remove.
+ */
+static void list_unlink(Node **head, Node **link, Node *node) {
+    list_detach(head, link, node);
+    list_free_node(node);
+}
+
+/**
+ * @brief Moves a node one step towards the head, or to the head, according
+ * to the self-organizing mode.
+ *
+ * The predecessors remembered by the search are used as they are if no write
+ * has happened since it released its lock; otherwise the node is looked up
+ * again, since it may have moved or gone.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param node The node found by a search.
+ * @param previous The node before it, or NULL if the search did not track it.
+ * @param before The node before `previous`, or NULL if that is the head.
+ * @param generation The value of `list_generation` during the search.
+ */
+static void list_promote(Node **head, Node *node, Node *previous, Node *before,
+                         unsigned long generation) {
+    dist_rwlock_wrlock(&list_lock);
+
+    Node *current = node;
+    if (!previous || generation != list_generation) {
+        before = previous = NULL;
+        current = *head;
+        while (current && current != node) {
+            before = previous;
+            previous = current;
+            current = current->next;
+        }
+    }
+    if (current && previous) {
+        list_detach(head, &previous->next, node);
+        if (organize_mode == LIST_ORGANIZE_TRANSPOSE)
+            list_attach(head, before ? &before->next : head, before, node);
+        else
+            list_attach(head, head, NULL, node);
+    }
+
+    list_wrunlock();
+}
+
+/**
+ * @brief Applies every pending request for a list. The caller must hold
+ * `combine_lock`.
+ *
+ * Requests of one round run concurrently, so they may take effect in any
+ * order; here the deletes come first and the appends last.
+ *
+ * @param head A double pointer to the head of the linked list.
+ */
+static void list_combine_run(Node **head) {
+    CombineSlot *batch[LIST_COMBINE_SLOTS];
+    int matched[LIST_COMBINE_SLOTS] = {0};
+    Node *unlinked[LIST_COMBINE_SLOTS];
+    size_t count = 0, deletes = 0, num_unlinked = 0;
+
+    for (int i = 0; i < LIST_COMBINE_SLOTS; i++) {
+        CombineSlot *slot = &combine_slots[i];
+        if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) !=
+                LIST_COMBINE_PENDING ||
+            slot->head != head)
+            continue;
+        batch[count++] = slot;
+        if (slot->op == LIST_OP_DELETE) deletes++;
+    }
+    if (!count) return;
+
+    dist_rwlock_wrlock(&list_lock);
+
+    // One walk serves every delete and ends on the tail.
+    Node **link = head;
+    Node *prev = NULL;
+    while (*link) {
+        Node *node = *link;
+        node_prefetch(node);
+        size_t i = count;
+        if (deletes) {
+            for (i = 0; i < count; i++)
+                if (!matched[i] && batch[i]->op == LIST_OP_DELETE &&
+                    batch[i]->data == node->data)
+                    break;
+        }
+        if (i < count) {
+            matched[i] = 1;
+            deletes--;
+            list_detach(head, link, node);
+            unlinked[num_unlinked++] = node;
+            continue;
+        }
+        prev = node;
+        link = &node->next;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (batch[i]->op != LIST_OP_INSERT) continue;
+        Node *node = batch[i]->node;
+        node->next = NULL;
+        node_set_jump(node, NULL);
+        node_set_prev(node, prev);
+        link_publish(link, node);
+        segment_note_append(head, node);
+        prev = node;
+        link = &node->next;
+    }
+
+    list_wrunlock();
+
+    for (size_t i = 0; i < count; i++)
+        __atomic_store_n(&batch[i]->state, LIST_COMBINE_DONE, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < num_unlinked; i++) list_free_node(unlinked[i]);
+}
+
+/**
+ * @brief Publishes a write request and waits until a combiner, possibly the
+ * calling thread, has applied it.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param op LIST_OP_INSERT or LIST_OP_DELETE.
+ * @param data The data to insert or delete.
+ * @param node The node to append (LIST_OP_INSERT).
+ */
+static void list_combine(Node **head, int op, uint16_t data, Node *node) {
+    if (combine_slot < 0)
+        combine_slot =
+            __atomic_fetch_add(&combine_next_slot, 1, __ATOMIC_RELAXED) %
+            LIST_COMBINE_SLOTS;
+    CombineSlot *slot = &combine_slots[combine_slot];
+
+    // Threads sharing a slot take turns.
+    int expected = LIST_COMBINE_FREE;
+    while (!__atomic_compare_exchange_n(&slot->state, &expected,
+                                        LIST_COMBINE_CLAIMED, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        expected = LIST_COMBINE_FREE;
+        sched_yield();
+    }
+    slot->op = op;
+    slot->data = data;
+    slot->head = head;
+    slot->node = node;
+    __atomic_store_n(&slot->state, LIST_COMBINE_PENDING, __ATOMIC_RELEASE);
+
+    while (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != LIST_COMBINE_DONE) {
+        if (pthread_mutex_trylock(&combine_lock) == 0) {
+            list_combine_run(head);
+            pthread_mutex_unlock(&combine_lock);
+        } else {
+            sched_yield();
+        }
+    }
+    __atomic_store_n(&slot->state, LIST_COMBINE_FREE, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Removes a node with the specified data from the linked list.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param data The data to insert into the linked list.
+ */
+void list_delete(Node **head, uint16_t data) {
+    if (*head == NULL) return;
+
+    if (combining_mode) {
+        list_combine(head, LIST_OP_DELETE, data, NULL);
+        return;
+    }
+
+    dist_rwlock_wrlock(&list_lock);
+
+    // If the data is on the first node.
+    if ((*head)->data == data) {
+        list_unlink(head, head, *head);
+        list_wrunlock();
+        return;
+    }
+
+    // If the data is on a general node.
+    Node *current = *head;
+    while (current->next) {
+        node_prefetch(current);
+        if (current->next->data == data) {
+            list_unlink(head, &current->next, current->next);
+            list_wrunlock();
+            return;
+        }
+        current = current->next;
+    }
+
+    list_wrunlock();
+}
+
+/**
+ * @brief Removes the given node from the linked list.
+ *
+ * With LIST_DOUBLY_LINKED this runs in O(1); otherwise the predecessor is
+ * found by walking from the head.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param node A pointer to the node to remove.
+ */
+void list_delete_node(Node **head, Node *node) {
+    if (*head == NULL || !node) return;
+
+    dist_rwlock_wrlock(&list_lock);
+
+    Node **link = list_link_to(head, node);
+    if (link) list_unlink(head, link, node);
+
+    list_wrunlock();
+}
+
+/**
+ * @brief Moves every node of `src` into `dst` after the given node. The
+ * caller must hold `list_lock` for writing.
+ */
+static void list_splice_locked(Node **dst, Node *after_node, Node **src) {
+    Node *first = *src;
+    if (!first) return;
+    Node *last = first;
+    while (last->next) last = last->next;
+
+    Node **link = after_node ? &after_node->next : dst;
+    Node *rest = *link;
+    link_publish(&last->next, rest);
+    if (rest) node_set_prev(rest, last);
+    node_set_prev(first, after_node);
+    link_publish(link, first);
+    link_publish(src, NULL);
+
+    segment_invalidate(dst, src);
+    relinearize_cursor = NULL;
+}
+
+/**
+ * @brief Moves every node of `src` into `dst` after the given node by
+ * relinking the ends of the chain. Nothing is allocated or copied; only the
+ * tail of `src` has to be found.
+ *
+ * @param dst A double pointer to the head of the receiving list.
+ * @param after_node The node of `dst` to splice after, or NULL to splice at
+ * the front.
+ * @param src A double pointer to the head of the list to move; left empty.
+ */
+void list_splice(Node **dst, Node *after_node, Node **src) {
+    if (dst == src) return;
+
+    dist_rwlock_wrlock(&list_lock);
+    list_splice_locked(dst, after_node, src);
+    list_wrunlock();
+}
+
+/**
+ * @brief Detaches every node after the given node into a separate list.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param at_node The node that becomes the tail of `head`, or NULL to detach
+ * the whole list.
+ * @param tail_out A double pointer to the head of an empty list receiving
+ * the detached nodes.
+ */
+void list_split(Node **head, Node *at_node, Node **tail_out) {
+    if (head == tail_out) return;
+
+    dist_rwlock_wrlock(&list_lock);
+
+    if (*tail_out) {
+        // Refuse to overwrite a list still holding nodes.
+        list_wrunlock();
+        return;
+    }
+    Node **link = at_node ? &at_node->next : head;
+    Node *first = *link;
+    if (first) {
+        node_set_prev(first, NULL);
+        link_publish(tail_out, first);
+        link_publish(link, NULL);
+        segment_invalidate(head, tail_out);
+        relinearize_cursor = NULL;
+    }
+
+    list_wrunlock();
+}
+
+/**
+ * @brief Appends every node of `b` to the end of `a`, leaving `b` empty.
+ *
+ * @param a A double pointer to the head of the list to extend.
+ * @param b A double pointer to the head of the list to move.
+ */
+void list_concat(Node **a, Node **b) {
+    if (a == b) return;
+
+    dist_rwlock_wrlock(&list_lock);
+
+    Node *tail = *a;
+    while (tail && tail->next) tail = tail->next;
+    list_splice_locked(a, tail, b);
+
+    list_wrunlock();
+}
+
+/**
+ * @brief Runs a batch of inserts, deletes and searches under a single write
+ * lock acquisition, in array order.
+ *
+ * The nodes for every insert are allocated in one pass before the lock is
+ * taken, and the deleted nodes are freed in one pass after it is released.
+ * Appends reuse the tail found by the first one instead of walking again.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param ops The operations. Each one's `result` is set to the inserted or
+ * found node, or for a delete to the former address of the removed node
+ * (not to be dereferenced); NULL if the operation failed. An insert after a
+ * node deleted earlier in the batch fails.
+ * @param n The number of operations.
+ * @return The number of operations that succeeded.
+ */
+size_t list_apply(Node **head, ListOp *ops, size_t n) {
+    size_t inserts = 0;
+    for (size_t i = 0; i < n; i++)
+        if (ops[i].op == LIST_OP_INSERT || ops[i].op == LIST_OP_INSERT_AFTER)
+            inserts++;
+
+    // Fresh nodes fill the front of the array, unlinked ones follow them.
+    Node **nodes = malloc((n ? n : 1) * sizeof(Node *));
+    if (!nodes) return 0;
+    size_t allocated = mem_alloc_many(sizeof(Node), inserts, (void **)nodes);
+    size_t used = 0, unlinked = 0, done = 0;
+
+    dist_rwlock_wrlock(&list_lock);
+
+    Node *tail = NULL;  // Found on the first append, NULL when unknown
+    for (size_t i = 0; i < n; i++) {
+        ListOp *op = &ops[i];
+        op->result = NULL;
+        Node *node;
+        Node **link;
+        switch (op->op) {
+            case LIST_OP_INSERT:
+                if (used == allocated) break;
+                node = nodes[used++];
+                node->data = op->data;
+                node->flags = 0;
+                node->next = NULL;
+                node_set_jump(node, NULL);
+                if (!tail) {
+                    tail = *head;
+                    while (tail && tail->next) tail = tail->next;
+                }
+                node_set_prev(node, tail);
+                link_publish(tail ? &tail->next : head, node);
+                segment_note_append(head, node);
+                tail = node;
+                op->result = node;
+                break;
+            case LIST_OP_INSERT_AFTER:
+                // A node deleted earlier in the batch is no anchor any more.
+                if (!op->node || (op->node->flags & NODE_UNLINKED) ||
+                    used == allocated)
+                    break;
+                node = nodes[used++];
+                node->data = op->data;
+                node->flags = 0;
+                list_attach(head, &op->node->next, op->node, node);
+                if (op->node == tail) tail = node;
+                op->result = node;
+                break;
+            case LIST_OP_DELETE:
+                link = head;
+                while (*link && (*link)->data != op->data)
+                    link = &(*link)->next;
+                if (!*link) break;
+                node = *link;
+                if (node == tail) tail = NULL;
+                list_detach(head, link, node);
+                node->flags |= NODE_UNLINKED;
+                nodes[inserts + unlinked++] = node;
+                op->result = node;
+                break;
+            case LIST_OP_SEARCH:
+                node = *head;
+                while (node && node->data != op->data) {
+                    node_prefetch(node);
+                    node = node->next;
+                }
+                op->result = node;
+                break;
+        }
+        if (op->result) done++;
+    }
+
+    list_wrunlock();
+
+    // Unused fresh nodes and, outside RCU mode, the unlinked ones go back to
+    // the pool together.
+    size_t count = 0;
+    for (size_t i = used; i < allocated; i++) nodes[count++] = nodes[i];
+    for (size_t i = inserts; i < inserts + unlinked; i++) {
+        if (rcu_mode)
+            rcu_defer_free(nodes[i], mem_free);
+        else
+            nodes[count++] = nodes[i];
+    }
+    if (rcu_mode) rcu_flush();
+    mem_free_many((void **)nodes, count);
+    free(nodes);
+    return done;
+}
+
+/**
+ * @brief Replaces up to `max_nodes` nodes, starting with the one `link`
+ * points to, by copies laid out in one contiguous span of the pool, and frees
+ * the originals. The caller must hold `list_lock` for writing.
+ *
+ * Nodes pinned with list_pin are stepped over and keep their address; the
+ * run stops at the first pinned node after a copied one. If no gap holds the
+ * whole span, the run is halved until one does. The originals are left
+ * untouched until they are freed, so a lock-free reader standing on one
+ * still sees a consistent chain.
+ *
+ * @param link The link pointing to the first node to move.
+ * @param prev The node owning `link`, or NULL if `link` is the head.
+ * @param max_nodes The maximum number of nodes to pass.
+ * @param last Receives the last node passed, copy or pinned.
+ * @return The number of nodes passed, 0 at the tail or if the memory ran out.
+ */
+static size_t relinearize_run(Node **link, Node *prev, size_t max_nodes,
+                              Node **last) {
+    size_t passed = 0;
+    while (*link && ((*link)->flags & NODE_PINNED) && passed < max_nodes) {
+        prev = *link;
+        link = &prev->next;
+        passed++;
+    }
+    *last = prev;
+
+    size_t wanted = 0;
+    for (Node *node = *link; node && !(node->flags & NODE_PINNED) &&
+                             passed + wanted < max_nodes;
+         node = node->next)
+        wanted++;
+    if (wanted == 0) return passed;
+
+    Node **fresh = malloc(wanted * sizeof(Node *));
+    if (!fresh) return passed;
+    size_t moved = wanted;
+    while (moved && !mem_alloc_span(sizeof(Node), moved, (void **)fresh))
+        moved /= 2;
+    if (moved == 0) {
+        free(fresh);
+        return passed;
+    }
+
+    Node *old = *link;
+    for (size_t i = 0; i < moved; i++, old = old->next) {
+        Node *copy = fresh[i];
+        copy->data = old->data;
+        copy->flags = old->flags;
+        node_set_jump(copy, node_get_jump(old));
+        if (i >= LIST_JUMP_DISTANCE)
+            node_set_jump(fresh[i - LIST_JUMP_DISTANCE], copy);
+        node_set_prev(copy, i ? fresh[i - 1] : prev);
+        if (i) fresh[i - 1]->next = copy;
+        if (old->flags & NODE_SEGMENT_ANCHOR) {
+            for (size_t j = 0; j < segment_count; j++)
+                if (segments[j] == old) segments[j] = copy;
+        }
+    }
+
+    // Splice the copies in, then release the originals.
+    fresh[moved - 1]->next = old;
+    if (old) node_set_prev(old, fresh[moved - 1]);
+    Node *original = *link;
+    link_publish(link, fresh[0]);
+    for (size_t i = 0; i < moved; i++) {
+        Node *next = original->next;
+        list_free_node(original);
+        original = next;
+    }
+
+    *last = fresh[moved - 1];
+    free(fresh);
+    return passed + moved;
+}
 
 /**
- * @brief Initializes the linked list.
+ * @brief Recomputes every jump link after inserts and deletes have left them
+ * inexact. Does nothing unless built with LIST_JUMP_POINTERS.
  *
  * @param head A double pointer to the head of the linked list.
- * @param size The size in bytes to allocate.
  */
-void list_init(Node **head, size_t size) {
-    mem_init(size);
-    *head = NULL;
-    pthread_rwlock_init(&list_lock, NULL);
+void list_update_jumps(Node **head) {
+    dist_rwlock_wrlock(&list_lock);
+    jump_rebuild(*head);
+    list_wrunlock();
 }
 
 /**
- * @brief Inserts the specified data at the end of the linked list.
+ * @brief Copies every node into fresh runs of memory in list order, so that
+ * a sequential traversal walks forward through the pool.
+ *
+ * Needs room in the pool for a second copy of the list. Pointers to nodes
+ * obtained before the call are no longer valid afterwards, except for nodes
+ * pinned with list_pin.
  *
  * @param head A double pointer to the head of the linked list.
- * @param data The data to insert into the linked list.
+ * @return 0 on success, -1 if the pool has no room for the copy.
  */
-void list_insert(Node **head, uint16_t data) {
-
-    Node *new_node = mem_alloc(sizeof(Node));
-    if (!new_node) {
-        // printf_red("Memory allocation for insertion failed!\n");
-        return;
-    }
+int list_relinearize(Node **head) {
+    dist_rwlock_wrlock(&list_lock);
 
-    pthread_rwlock_wrlock(&list_lock);
+    size_t remaining = 0;
+    for (Node *current = *head; current; current = current->next) remaining++;
 
-    if (*head == NULL)
-        *head = new_node;
-    else {
-        Node *current = *head;
-        while (current->next != NULL) current = current->next;
-        current->next = new_node;
+    Node *prev = NULL;
+    int result = 0;
+    while (remaining) {
+        size_t passed =
+            relinearize_run(prev ? &prev->next : head, prev, remaining, &prev);
+        if (passed == 0) {
+            // Part of the list moved before the memory ran out.
+            result = -1;
+            break;
+        }
+        remaining -= passed;
     }
-    new_node->data = data;
-    new_node->next = NULL;
+    jump_rebuild(*head);
+    relinearize_cursor = NULL;
 
-    pthread_rwlock_unlock(&list_lock);
+    list_wrunlock();
+    return result;
 }
 
 /**
- * @brief Inserts the specified data after the given node.
+ * @brief Relinearizes the next `max_nodes` nodes of an incremental pass.
  *
- * @param prev_node A pointer to the node to insert data after.
- * @param data The data to insert into the linked list.
+ * Each step holds `list_lock` only for its own nodes and continues where the
+ * previous one stopped, so a long list can be compacted a little at a time.
+ * Pointers to moved nodes are no longer valid afterwards; pinned nodes are
+ * stepped over.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param max_nodes The maximum number of nodes to pass.
+ * @return The number of nodes passed. Fewer than `max_nodes` means the step
+ * stopped at a pinned node, found no free span for the full step or reached
+ * the tail; 0 means the pass is over and the next step starts over.
  */
-void list_insert_after(Node *prev_node, uint16_t data) {
-    if (!prev_node) {
-        // printf_red("Previous node is null!\n");
-        return;
-    }
+size_t list_relinearize_step(Node **head, size_t max_nodes) {
+    if (max_nodes == 0) return 0;
 
-    pthread_rwlock_wrlock(&list_lock);
+    dist_rwlock_wrlock(&list_lock);
 
-    Node *next_node = prev_node->next;
-    Node *new_node = mem_alloc(sizeof(Node));
-    if (!new_node) {
-        pthread_rwlock_unlock(&list_lock);
-        // printf_red("Memory allocation for insertion after failed!\n");
-        return;
+    if (head != relinearize_cursor_head) relinearize_cursor = NULL;
+    relinearize_cursor_head = head;
+    Node *prev = relinearize_cursor;
+    Node **link = prev ? &prev->next : head;
+    Node *last = NULL;
+    size_t passed = relinearize_run(link, prev, max_nodes, &last);
+    relinearize_cursor = passed ? last : NULL;
+
+    list_wrunlock();
+    return passed;
+}
+
+static void *relinearize_worker(void *arg) {
+    while (__atomic_load_n(&relinearize_running, __ATOMIC_ACQUIRE)) {
+        size_t moved =
+            list_relinearize_step(relinearize_list, relinearize_nodes_per_step);
+
+        // Rest longer between passes than between steps.
+        unsigned int pause = relinearize_interval_us;
+        if (moved < relinearize_nodes_per_step) pause *= 16;
+        usleep(pause);
     }
-    new_node->data = data;
-    prev_node->next = new_node;
-    new_node->next = next_node;
+    return NULL;
+}
+
+/**
+ * @brief Starts a background thread that relinearizes the list one step at a
+ * time. While it runs, only node pointers obtained through list_pin stay
+ * valid; any other may go stale at any moment.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param nodes_per_step The number of nodes moved per step.
+ * @param interval_us The pause between steps in microseconds.
+ * @return 0 on success, -1 if it is already running or the thread could not
+ * be created.
+ */
+int list_relinearize_start(Node **head, size_t nodes_per_step,
+                           unsigned int interval_us) {
+    if (relinearize_running || nodes_per_step == 0) return -1;
+    relinearize_list = head;
+    relinearize_nodes_per_step = nodes_per_step;
+    relinearize_interval_us = interval_us;
+    relinearize_running = 1;
+    if (pthread_create(&relinearize_thread, NULL, relinearize_worker, NULL)) {
+        relinearize_running = 0;
+        return -1;
+    }
+    return 0;
+}
 
-    pthread_rwlock_unlock(&list_lock);
+/**
+ * @brief Stops the background relinearization thread, if any.
+ */
+void list_relinearize_stop() {
+    if (!relinearize_running) return;
+    __atomic_store_n(&relinearize_running, 0, __ATOMIC_RELEASE);
+    pthread_join(relinearize_thread, NULL);
 }
 
 /**
- * @brief Inserts the specified data before the given node.
+ * @brief Finds the first node holding the specified data and pins it, so
+ * relinearization leaves it where it is and the returned pointer stays valid
+ * while the background pass runs. Pins do not nest.
  *
  * @param head A double pointer to the head of the linked list.
- * @param prev_node A pointer to the node to insert data before.
- * @param data The data to insert into the linked list.
+ * @param data The data to search for.
+ * @return The pinned node, or NULL if there is none.
  */
-void list_insert_before(Node **head, Node *next_node, uint16_t data) {
-    if (*head == NULL || !next_node) return;
+Node *list_pin(Node **head, uint16_t data) {
+    dist_rwlock_wrlock(&list_lock);
+    Node *current = *head;
+    while (current && current->data != data) current = current->next;
+    if (current) current->flags |= NODE_PINNED;
+    list_wrunlock();
+    return current;
+}
 
-    pthread_rwlock_wrlock(&list_lock);
+/**
+ * @brief Lets relinearization move a node pinned with list_pin again. The
+ * pointer must not be used afterwards while the background pass runs.
+ *
+ * @param node The pinned node.
+ */
+void list_unpin(Node *node) {
+    dist_rwlock_wrlock(&list_lock);
+    node->flags &= ~NODE_PINNED;
+    list_wrunlock();
+}
 
-    Node *new_node = mem_alloc(sizeof(Node));
-    if (!new_node) {
-        pthread_rwlock_unlock(&list_lock);
-        // printf_red("Memory allocation for insertion before failed!\n");
+static void search_segment(ListJob *job, size_t segment, Node *start,
+                           Node *end) {
+    // A match in an earlier segment makes this one irrelevant.
+    if (__atomic_load_n(&job->found_segment, __ATOMIC_RELAXED) < segment)
         return;
+
+    for (Node *current = start; current != end; current = current->next) {
+        node_prefetch(current);
+        if (current->data == job->data) {
+            job->found[segment] = current;
+            size_t best = __atomic_load_n(&job->found_segment, __ATOMIC_RELAXED);
+            while (segment < best &&
+                   !__atomic_compare_exchange_n(&job->found_segment, &best,
+                                                segment, 0, __ATOMIC_RELAXED,
+                                                __ATOMIC_RELAXED))
+                ;
+            return;
+        }
     }
+}
 
-    new_node->data = data;
-    new_node->next = next_node;
+/**
+ * @brief Searches for a node with the specified data and returns a pointer to
+ * it.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param data The data to insert into the linked list.
+ * @return A pointer to the returned node.
+ */
+Node *list_search(Node **head, uint16_t data) {
+    if (rcu_mode && list_rcu_enter()) {
+        Node *current = link_follow(head);
+        while (current && current->data != data) {
+            node_prefetch(current);
+            current = link_follow(&current->next);
+        }
+        rcu_read_unlock();
+        return current;
+    }
 
-    // If insert before the head node.
-    if (next_node == *head) {
-        *head = new_node;
-        pthread_rwlock_unlock(&list_lock);
-        return;
+    dist_rwlock_rdlock(&list_lock);
+
+    Node *result = NULL, *previous = NULL, *before = NULL;
+    ListJob job = {
+        .run = search_segment, .data = data, .found_segment = SIZE_MAX};
+    if (list_run_parallel(head, &job)) {
+        if (job.found_segment < job.count)
+            result = job.found[job.found_segment];
+        list_job_release(&job);
+    } else {
+        result = *head;
+        while (result && result->data != data) {
+            node_prefetch(result);
+            before = previous;
+            previous = result;
+            result = result->next;
+        }
     }
+    int promote = organize_mode && !rcu_mode && result && result != *head;
+    unsigned long generation = list_generation;
 
-    // Insert before a general node.
-    Node *current = *head;
-    while (current && current->next != next_node) current = current->next;
-    if (current) current->next = new_node;
+    dist_rwlock_rdunlock(&list_lock);
 
-    pthread_rwlock_unlock(&list_lock);
+    if (promote) list_promote(head, result, previous, before, generation);
+    return result;
 }
 
 /**
- * @brief Removes a node with the specified data from the linked list.
+ * @brief Searches for a node with the specified data, starting at a node
+ * close to it (a finger) and wrapping around to the head.
+ *
+ * Repeated lookups of a value near a remembered node then cost a few hops
+ * instead of a scan from the head. The list order is left alone.
  *
  * @param head A double pointer to the head of the linked list.
- * @param data The data to insert into the linked list.
+ * @param hint A node of the list to start from, such as the result of an
+ * earlier search, or NULL to start at the head.
+ * @param data The data to search for.
+ * @return A pointer to the node, or NULL if the data is not in the list.
  */
-void list_delete(Node **head, uint16_t data) {
-    if (*head == NULL) return;
+Node *list_search_from(Node **head, Node *hint, uint16_t data) {
+    dist_rwlock_rdlock(&list_lock);
 
-    pthread_rwlock_wrlock(&list_lock);
-
-    // If the data is on the first node.
-    if ((*head)->data == data) {
-        Node *temp = *head;
-        *head = temp->next;
-        mem_free(temp);
-        pthread_rwlock_unlock(&list_lock);
-        return;
+    Node *result = hint ? hint : *head;
+    while (result && result->data != data) {
+        node_prefetch(result);
+        result = result->next;
     }
-
-    // If the data is on a general node.
-    Node *current = *head;
-    while (current->next) {
-        if (current->next->data == data) {
-            Node *temp = current->next;
-            current->next = temp->next;
-            mem_free(temp);
-            pthread_rwlock_unlock(&list_lock);
-            return;
+    if (!result && hint) {
+        // A hint no longer on the list is never met again, so the walk can
+        // reach the tail.
+        result = *head;
+        while (result && result != hint && result->data != data) {
+            node_prefetch(result);
+            result = result->next;
         }
-        current = current->next;
+        if (result == hint) result = NULL;
     }
 
-    pthread_rwlock_unlock(&list_lock);
+    dist_rwlock_rdunlock(&list_lock);
+    return result;
+}
+
+typedef struct {
+    uint16_t key;
+    size_t index;  // Position of the key in the caller's array
+} KeyIndex;
+
+static int compare_key_index(const void *a, const void *b) {
+    return ((const KeyIndex *)a)->key - ((const KeyIndex *)b)->key;
 }
 
 /**
- * @brief Searches for a node with the specified data and returns a pointer to
- * it.
+ * @brief Looks up many values in a single traversal under one lock
+ * acquisition.
+ *
+ * The keys go into a 65,536-bit membership bitmap, so checking a node costs
+ * one bit test whatever the number of keys, and the walk stops once every
+ * key is found. The key positions are sorted by key beforehand, so a hit
+ * finds every position asking for its value with one binary search. The list
+ * order is left alone.
  *
  * @param head A double pointer to the head of the linked list.
- * @param data The data to insert into the linked list.
- * @return A pointer to the returned node.
+ * @param keys The values to look up; duplicates are allowed.
+ * @param n The number of keys.
+ * @param results Receives, for each key, the first node holding it or NULL.
+ * @return The number of keys found, or 0 if the memory ran out.
  */
-Node *list_search(Node **head, uint16_t data) {
-    pthread_rwlock_rdlock(&list_lock);
+size_t list_search_many(Node **head, const uint16_t *keys, size_t n,
+                        Node **results) {
+    for (size_t i = 0; i < n; i++) results[i] = NULL;
+    if (n == 0) return 0;
+    KeyIndex *order = malloc(n * sizeof(KeyIndex));
+    if (!order) return 0;
 
-    Node *current = *head;
-    while (current) {
-        if (current->data == data) {
-            pthread_rwlock_unlock(&list_lock);
-            return current;
+    uint64_t pending[(UINT16_MAX + 1) / 64] = {0};
+    size_t remaining = 0;
+    for (size_t i = 0; i < n; i++) {
+        order[i] = (KeyIndex){keys[i], i};
+        uint64_t bit = 1ull << (keys[i] % 64);
+        if (!(pending[keys[i] / 64] & bit)) remaining++;
+        pending[keys[i] / 64] |= bit;
+    }
+    qsort(order, n, sizeof(KeyIndex), compare_key_index);
+
+    int lockless = rcu_mode && list_rcu_enter();
+    if (!lockless) dist_rwlock_rdlock(&list_lock);
+
+    size_t found = 0;
+    for (Node *current = link_follow(head); current && remaining;
+         current = link_follow(&current->next)) {
+        node_prefetch(current);
+        uint16_t data = current->data;
+        uint64_t bit = 1ull << (data % 64);
+        if (!(pending[data / 64] & bit)) continue;
+
+        // First node with this value: hand it to every key asking for it.
+        pending[data / 64] &= ~bit;
+        remaining--;
+        size_t low = 0, high = n;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (order[middle].key < data)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        for (; low < n && order[low].key == data; low++) {
+            results[order[low].index] = current;
+            found++;
         }
-        current = current->next;
     }
 
-    pthread_rwlock_unlock(&list_lock);
-    return NULL;
+    if (lockless)
+        rcu_read_unlock();
+    else
+        dist_rwlock_rdunlock(&list_lock);
+    free(order);
+    return found;
 }
 
 /**
@@ -185,7 +1625,7 @@ void list_display(Node **head) { list_display_range(head, NULL, NULL); }
  * @param end_node A pointer to the end node (NULL for end of linked list).
  */
 void list_display_range(Node **head, Node *start_node, Node *end_node) {
-    pthread_rwlock_rdlock(&list_lock);
+    dist_rwlock_rdlock(&list_lock);
 
     printf("[");
     if (!start_node) start_node = *head;
@@ -197,7 +1637,17 @@ void list_display_range(Node **head, Node *start_node, Node *end_node) {
     }
     printf("]");
 
-    pthread_rwlock_unlock(&list_lock);
+    dist_rwlock_rdunlock(&list_lock);
+}
+
+static void count_segment(ListJob *job, size_t segment, Node *start,
+                          Node *end) {
+    uint64_t count = 0;
+    for (Node *current = start; current != end; current = current->next) {
+        node_prefetch(current);
+        count++;
+    }
+    job->partials[segment] = count;
 }
 
 /**
@@ -207,41 +1657,437 @@ void list_display_range(Node **head, Node *start_node, Node *end_node) {
  * @return The number of nodes in the linked list.
  */
 int list_count_nodes(Node **head) {
-    pthread_rwlock_rdlock(&list_lock);
+    if (rcu_mode && list_rcu_enter()) {
+        int count = 0;
+        for (Node *current = link_follow(head); current;
+             current = link_follow(&current->next)) {
+            node_prefetch(current);
+            count++;
+        }
+        rcu_read_unlock();
+        return count;
+    }
+
+    dist_rwlock_rdlock(&list_lock);
 
     if (*head == NULL) {
-        pthread_rwlock_unlock(&list_lock);
+        dist_rwlock_rdunlock(&list_lock);
         return 0;
     }
     int count = 0;
 
+    ListJob job = {.run = count_segment};
+    if (list_run_parallel(head, &job)) {
+        for (size_t i = 0; i < job.count; i++) count += job.partials[i];
+        list_job_release(&job);
+        dist_rwlock_rdunlock(&list_lock);
+        return count;
+    }
+
     Node *current = *head;
     while (current) {
+        node_prefetch(current);
         count++;
         current = current->next;
     }
 
-    pthread_rwlock_unlock(&list_lock);
+    dist_rwlock_rdunlock(&list_lock);
     return count;
 }
 
+static void reduce_segment(ListJob *job, size_t segment, Node *start,
+                           Node *end) {
+    uint64_t acc = job->identity;
+    for (Node *current = start; current != end; current = current->next) {
+        node_prefetch(current);
+        acc = job->fn(acc, current->data);
+    }
+    job->partials[segment] = acc;
+}
+
+/**
+ * @brief Folds the data of every node into a single value.
+ *
+ * Long lists are split into segments that are folded in parallel, starting
+ * from `identity`, and the partial results are combined in list order.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param fn The function folding one node's data into an accumulator.
+ * @param combine An associative function merging two partial results.
+ * @param identity The identity element of `combine`.
+ * @return The folded value, or `identity` for an empty list.
+ */
+uint64_t list_reduce(Node **head, list_reduce_fn fn, list_combine_fn combine,
+                     uint64_t identity) {
+    if (rcu_mode && list_rcu_enter()) {
+        uint64_t acc = identity;
+        for (Node *current = link_follow(head); current;
+             current = link_follow(&current->next)) {
+            node_prefetch(current);
+            acc = fn(acc, current->data);
+        }
+        rcu_read_unlock();
+        return acc;
+    }
+
+    dist_rwlock_rdlock(&list_lock);
+
+    ListJob job = {.run = reduce_segment, .fn = fn, .identity = identity};
+    if (list_run_parallel(head, &job)) {
+        uint64_t acc = identity;
+        for (size_t i = 0; i < job.count; i++)
+            acc = combine(acc, job.partials[i]);
+        list_job_release(&job);
+        dist_rwlock_rdunlock(&list_lock);
+        return acc;
+    }
+
+    uint64_t acc = identity;
+    for (Node *current = *head; current; current = current->next) {
+        node_prefetch(current);
+        acc = fn(acc, current->data);
+    }
+
+    dist_rwlock_rdunlock(&list_lock);
+    return acc;
+}
+
+static int sort_ascending(uint16_t a, uint16_t b) { return (a > b) - (a < b); }
+
+/**
+ * @brief Merges two sorted chains, taking from `a` on ties.
+ *
+ * @param a The first chain.
+ * @param b The second chain.
+ * @param cmp The comparison function.
+ * @param last Receives the last node of the merged chain.
+ * @return The first node of the merged chain.
+ */
+static Node *sort_merge(Node *a, Node *b, list_compare_fn cmp, Node **last) {
+    Node *first = NULL, **tail = &first, *previous = NULL;
+    while (a && b) {
+        if (cmp(b->data, a->data) < 0) {
+            *tail = b;
+            b = b->next;
+        } else {
+            *tail = a;
+            a = a->next;
+        }
+        previous = *tail;
+        tail = &previous->next;
+    }
+    *tail = a ? a : b;
+    while (*tail) {
+        previous = *tail;
+        tail = &previous->next;
+    }
+    *last = previous;
+    return first;
+}
+
+/**
+ * @brief Cuts a chain after its first `length` nodes.
+ *
+ * @param first The first node of the chain.
+ * @param length The number of nodes to keep.
+ * @return The first node after the cut, or NULL if the chain is shorter.
+ */
+static Node *sort_cut(Node *first, size_t length) {
+    for (size_t i = 1; first && i < length; i++) first = first->next;
+    if (!first) return NULL;
+    Node *rest = first->next;
+    first->next = NULL;
+    return rest;
+}
+
+/**
+ * @brief Sorts a NULL-terminated chain bottom-up, merging runs of width 1, 2,
+ * 4, ... in place. Needs no memory beyond a few locals.
+ *
+ * @param first The first node of the chain.
+ * @param cmp The comparison function.
+ * @return The first node of the sorted chain.
+ */
+static Node *sort_chain(Node *first, list_compare_fn cmp) {
+    for (size_t width = 1;; width *= 2) {
+        Node *sorted = NULL, **tail = &sorted;
+        size_t merges = 0;
+        while (first) {
+            Node *a = first;
+            Node *b = sort_cut(a, width);
+            first = sort_cut(b, width);
+            Node *last;
+            *tail = sort_merge(a, b, cmp, &last);
+            tail = &last->next;
+            merges++;
+        }
+        if (merges <= 1) return sorted;
+        first = sorted;
+    }
+}
+
+static void sort_segment(ListJob *job, size_t segment, Node *start,
+                         Node *end) {
+    job->found[segment] = sort_chain(job->starts[segment], job->cmp);
+}
+
+static void merge_segment(ListJob *job, size_t segment, Node *start,
+                          Node *end) {
+    Node *last;
+    job->found[segment] = sort_merge(job->starts[2 * segment],
+                                     job->starts[2 * segment + 1], job->cmp,
+                                     &last);
+}
+
+/**
+ * @brief Sorts the list in place by relinking its nodes (a stable merge
+ * sort). Long lists are cut into chunks that are sorted on the worker pool
+ * and then merged pairwise in parallel. Nothing is allocated.
+ *
+ * In RCU mode, the sort waits for the lock-free readers already running and
+ * makes new ones take list_lock until it is done, since a reader following
+ * nodes as they are relinked could count one twice or miss one.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param cmp A function returning a negative, zero or positive value as its
+ * first argument orders before, with or after its second, or NULL to sort
+ * by ascending data.
+ */
+void list_sort(Node **head, list_compare_fn cmp) {
+    if (!cmp) cmp = sort_ascending;
+
+    list_wrlock_exclusive();
+
+    size_t count = 0;
+    for (Node *current = *head; current; current = current->next) count++;
+
+    // One chunk per worker, each at least a segment long.
+    size_t chunks = pool_size;
+    if (chunks > count / segment_length) chunks = count / segment_length;
+
+    Node *sorted;
+    if (chunks < 2) {
+        sorted = sort_chain(*head, cmp);
+    } else {
+        Node *runs[2][LIST_MAX_WORKERS];
+        Node *first = *head;
+        for (size_t i = 0; i < chunks; i++) {
+            runs[0][i] = first;
+            size_t length = count / chunks + (i < count % chunks);
+            first = sort_cut(first, length);
+        }
+        ListJob job = {.run = sort_segment,
+                       .starts = runs[0],
+                       .count = chunks,
+                       .found = runs[1],
+                       .cmp = cmp};
+        list_job_dispatch(&job);
+
+        // Merge neighbouring chunks pairwise, halving their number each round.
+        Node **in = runs[1], **out = runs[0];
+        while (chunks > 1) {
+            job = (ListJob){.run = merge_segment,
+                            .starts = in,
+                            .count = chunks / 2,
+                            .found = out,
+                            .cmp = cmp};
+            list_job_dispatch(&job);
+            if (chunks % 2) out[chunks / 2] = in[chunks - 1];
+            chunks = (chunks + 1) / 2;
+            Node **swap = in;
+            in = out;
+            out = swap;
+        }
+        sorted = in[0];
+    }
+
+    Node *previous = NULL;
+    for (Node *current = sorted; current; current = current->next) {
+        node_set_prev(current, previous);
+        previous = current;
+    }
+    jump_rebuild(sorted);
+    link_publish(head, sorted);
+    segment_invalidate(head, head);
+    relinearize_cursor = NULL;
+
+    list_wrunlock_exclusive();
+}
+
+/**
+ * @brief Drops the list and every bookkeeping pointer into its nodes. The
+ * caller must hold `list_lock` for writing and free the nodes itself.
+ *
+ * @param head A double pointer to the head of the linked list.
+ */
+static void list_forget(Node **head) {
+    *head = NULL;
+    segment_head = NULL;
+    segment_count = 0;
+    segment_nodes = 0;
+    segment_drift = 0;
+    segment_tail_run = 0;
+    segment_stale = 0;
+    relinearize_cursor = NULL;
+}
+
+/**
+ * @brief Empties the list in O(1), keeping its pool for the nodes that
+ * follow. No other thread may use the list during the call.
+ *
+ * @param head A double pointer to the head of the linked list.
+ */
+void list_reset(Node **head) {
+    rcu_barrier();
+
+    dist_rwlock_wrlock(&list_lock);
+    list_forget(head);
+    segment_head = head;
+    mem_reset();
+    list_wrunlock();
+}
+
 /**
  * @brief Frees all the nodes in the linked list.
  *
+ * The pool created by list_init holds nothing but nodes, so it is released
+ * as a whole instead of node by node.
+ *
  * @param head A double pointer to the head of the linked list.
  */
 void list_cleanup(Node **head) {
-    pthread_rwlock_wrlock(&list_lock);
+    list_relinearize_stop();
+    list_pool_stop();
+    rcu_barrier();
+
+    dist_rwlock_wrlock(&list_lock);
+
+    list_forget(head);
+    mem_deinit();
+
+    free(segments);
+    segments = NULL;
+    segment_capacity = 0;
+
+    list_wrunlock();
+    dist_rwlock_destroy(&list_lock);
+}
+
+/**
+ * @brief Saves the data of every node to a file.
+ *
+ * The file holds a header followed by the payloads packed as uint16_t, in list
+ * order, so `list_load` can use the mapped file without parsing it.
+ *
+ * @param head A double pointer to the head of the linked list.
+ * @param path The path of the file to write.
+ * @return 0 on success, -1 on failure.
+ */
+int list_save(Node **head, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return -1;
+
+    dist_rwlock_rdlock(&list_lock);
+
+    ListFileHeader header = {.magic = LIST_FILE_MAGIC,
+                             .version = LIST_FILE_VERSION};
+    int failed = fwrite(&header, sizeof(header), 1, file) != 1;
 
+    // Stream the payloads and patch the count in afterwards.
     Node *current = *head;
-    while (current) {
-        Node *temp = current;
+    while (current && !failed) {
+        failed = fwrite(&current->data, sizeof(uint16_t), 1, file) != 1;
+        header.count++;
         current = current->next;
-        mem_free(temp);
     }
-    *head = NULL;
-    mem_deinit();
 
-    pthread_rwlock_unlock(&list_lock);
-    pthread_rwlock_destroy(&list_lock);
+    dist_rwlock_rdunlock(&list_lock);
+
+    if (!failed) failed = fseek(file, 0, SEEK_SET) != 0;
+    if (!failed) failed = fwrite(&header, sizeof(header), 1, file) != 1;
+    if (fclose(file) != 0) failed = 1;
+    return failed ? -1 : 0;
+}
+
+/**
+ * @brief Appends the nodes stored in a file written by `list_save`.
+ *
+ * The file is mapped and its payload array is read in place. All nodes are
+ * allocated in one batch and linked in a single pass under one lock
+ * acquisition, instead of one `list_insert` per element.
+ *
+ * @param head A double pointer to the head of an initialized linked list.
+ * @param path The path of the file to read.
+ * @return 0 on success, -1 on failure (the list is left unchanged).
+ */
+int list_load(Node **head, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ListFileHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return -1;
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+    const ListFileHeader *header = mapped;
+    const uint16_t *payload = (const uint16_t *)(header + 1);
+    size_t count = header->count;
+    if (header->magic != LIST_FILE_MAGIC ||
+        header->version != LIST_FILE_VERSION ||
+        count > (st.st_size - sizeof(ListFileHeader)) / sizeof(uint16_t)) {
+        munmap(mapped, st.st_size);
+        return -1;
+    }
+    if (count == 0) {
+        munmap(mapped, st.st_size);
+        return 0;
+    }
+
+    Node **nodes = malloc(count * sizeof(Node *));
+    if (!nodes) {
+        munmap(mapped, st.st_size);
+        return -1;
+    }
+
+    size_t allocated = mem_alloc_many(sizeof(Node), count, (void **)nodes);
+    if (allocated < count) {
+        mem_free_many((void **)nodes, allocated);
+        free(nodes);
+        munmap(mapped, st.st_size);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        nodes[i]->data = payload[i];
+        nodes[i]->flags = 0;
+        nodes[i]->next = i + 1 < count ? nodes[i + 1] : NULL;
+        node_set_prev(nodes[i], i > 0 ? nodes[i - 1] : NULL);
+        node_set_jump(nodes[i], i + LIST_JUMP_DISTANCE < count
+                                    ? nodes[i + LIST_JUMP_DISTANCE]
+                                    : NULL);
+    }
+
+    dist_rwlock_wrlock(&list_lock);
+
+    if (*head == NULL)
+        link_publish(head, nodes[0]);
+    else {
+        Node *current = *head;
+        while (current->next != NULL) current = current->next;
+        node_set_prev(nodes[0], current);
+        link_publish(&current->next, nodes[0]);
+    }
+    for (size_t i = 0; i < count; i++) segment_note_append(head, nodes[i]);
+
+    list_wrunlock();
+
+    free(nodes);
+    munmap(mapped, st.st_size);
+    return 0;
 }
@@ -10,21 +10,98 @@
 // #include "common_defs.h"
 #include "memory_manager.h"
 
+// Default number of nodes per segment of the segment directory.
+#ifndef LIST_SEGMENT_LENGTH
+#define LIST_SEGMENT_LENGTH 16384
+#endif
+
+// Define LIST_DOUBLY_LINKED when building the list and every file including
+// this header to give each node a `prev` link. list_insert_before and
+// list_delete_node then run in O(1) instead of walking from the head.
+
+// Define LIST_JUMP_POINTERS to give each node a `jump` link about
+// LIST_JUMP_DISTANCE nodes ahead. Traversals prefetch along it so that the
+// cache misses of upcoming nodes overlap instead of following one another.
+// Jump links are only hints: inserts and deletes keep them approximately
+// right, and list_update_jumps() makes them exact again.
+#ifndef LIST_JUMP_DISTANCE
+#define LIST_JUMP_DISTANCE 8
+#endif
+
+// Node flags.
+#define NODE_SEGMENT_ANCHOR 0x1  // The node starts a directory segment
+#define NODE_PINNED 0x2          // Relinearization must not move the node
+#define NODE_UNLINKED 0x4        // Deleted by the running list_apply batch
+
 typedef struct Node {
     uint16_t data;
+    uint16_t flags;
     struct Node *next;
-    pthread_mutex_t lock;
+#ifdef LIST_DOUBLY_LINKED
+    struct Node *prev;
+#endif
+#ifdef LIST_JUMP_POINTERS
+    struct Node *jump;
+#endif
 } Node;
 
+// Self-organizing modes for list_set_self_organizing.
+#define LIST_ORGANIZE_NONE 0
+#define LIST_ORGANIZE_MOVE_TO_FRONT 1  // Move a found node to the head
+#define LIST_ORGANIZE_TRANSPOSE 2      // Swap a found node with its predecessor
+
+// Operations for list_apply.
+#define LIST_OP_INSERT 0        // Append `data` to the list
+#define LIST_OP_INSERT_AFTER 1  // Insert `data` after `node`
+#define LIST_OP_DELETE 2        // Remove the first node holding `data`
+#define LIST_OP_SEARCH 3        // Find the first node holding `data`
+
+typedef struct {
+    int op;
+    uint16_t data;
+    Node *node;    // The node to insert after (LIST_OP_INSERT_AFTER)
+    Node *result;  // Set by list_apply
+} ListOp;
+
+typedef uint64_t (*list_reduce_fn)(uint64_t acc, uint16_t data);
+typedef uint64_t (*list_combine_fn)(uint64_t a, uint64_t b);
+typedef int (*list_compare_fn)(uint16_t a, uint16_t b);
+
 void list_init(Node **head, size_t size);
+void list_set_parallelism(int num_workers, size_t nodes_per_segment);
+void list_set_rcu(int enabled);
+void list_set_self_organizing(int mode);
+void list_set_combining(int enabled);
 void list_insert(Node **head, uint16_t data);
 void list_insert_after(Node *prev_node, uint16_t data);
 void list_insert_before(Node **head, Node *next_node, uint16_t data);
 void list_delete(Node **head, uint16_t data);
+void list_delete_node(Node **head, Node *node);
+size_t list_apply(Node **head, ListOp *ops, size_t n);
 Node *list_search(Node **head, uint16_t data);
+Node *list_search_from(Node **head, Node *hint, uint16_t data);
+size_t list_search_many(Node **head, const uint16_t *keys, size_t n,
+                        Node **results);
 void list_display(Node **head);
 void list_display_range(Node **head, Node *start_node, Node *end_node);
 int list_count_nodes(Node **head);
+uint64_t list_reduce(Node **head, list_reduce_fn fn, list_combine_fn combine,
+                     uint64_t identity);
+void list_sort(Node **head, list_compare_fn cmp);
+void list_splice(Node **dst, Node *after_node, Node **src);
+void list_split(Node **head, Node *at_node, Node **tail_out);
+void list_concat(Node **a, Node **b);
+void list_update_jumps(Node **head);
+int list_relinearize(Node **head);
+size_t list_relinearize_step(Node **head, size_t max_nodes);
+int list_relinearize_start(Node **head, size_t nodes_per_step,
+                           unsigned int interval_us);
+void list_relinearize_stop();
+Node *list_pin(Node **head, uint16_t data);
+void list_unpin(Node *node);
+void list_reset(Node **head);
 void list_cleanup(Node **head);
+int list_save(Node **head, const char *path);
+int list_load(Node **head, const char *path);
 
 #endif
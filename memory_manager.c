@@ -1,10 +1,74 @@
 #include "memory_manager.h"
 
+#include <stdint.h>
+
+// Number of block descriptors carved from each descriptor chunk.
+#define MEM_BLOCKS_PER_CHUNK 256
+
 void *memory;
 MemoryBlock *memory_head;
 size_t memory_size;
 pthread_mutex_t lock;
 
+// Block descriptors come from chunks that outlive the allocations, so that
+// mem_reset can drop every allocation at once and reuse the chunks.
+typedef struct BlockChunk {
+    struct BlockChunk *next;
+    MemoryBlock blocks[MEM_BLOCKS_PER_CHUNK];
+} BlockChunk;
+
+static BlockChunk *chunk_first;
+static BlockChunk *chunk_current;  // The chunk descriptors are carved from
+static size_t chunk_used;          // Descriptors carved from chunk_current
+static MemoryBlock *free_blocks;   // Released descriptors, linked by `next`
+
+/**
+ * @brief Takes a block descriptor, from the released ones if possible.
+ *
+ * @return A descriptor, or NULL if a new chunk could not be allocated.
+ */
+static MemoryBlock *block_new() {
+    if (free_blocks) {
+        MemoryBlock *block = free_blocks;
+        free_blocks = block->next;
+        return block;
+    }
+    if (!chunk_current || chunk_used == MEM_BLOCKS_PER_CHUNK) {
+        BlockChunk *next = chunk_current ? chunk_current->next : chunk_first;
+        if (!next) {
+            next = malloc(sizeof(BlockChunk));
+            if (!next) return NULL;
+            next->next = NULL;
+            if (chunk_current)
+                chunk_current->next = next;
+            else
+                chunk_first = next;
+        }
+        chunk_current = next;
+        chunk_used = 0;
+    }
+    return &chunk_current->blocks[chunk_used++];
+}
+
+/**
+ * @brief Returns a block descriptor for reuse.
+ *
+ * @param block The descriptor, no longer linked from `memory_head`.
+ */
+static void block_release(MemoryBlock *block) {
+    block->next = free_blocks;
+    free_blocks = block;
+}
+
+/**
+ * @brief Marks every block descriptor unused without freeing any chunk.
+ */
+static void block_reset() {
+    chunk_current = NULL;
+    chunk_used = 0;
+    free_blocks = NULL;
+}
+
 /**
  * @brief Initializes the memory manager with the specified size.
  *
@@ -14,6 +78,7 @@ void mem_init(size_t size) {
     memory = malloc(size);
     memory_head = NULL;
     memory_size = size;
+    block_reset();
     pthread_mutex_init(&lock, NULL);
 }
 
@@ -28,7 +93,7 @@ void *mem_alloc_no_lock(size_t size) {
     if (!memory || size > memory_size) return NULL;
     if (size == 0) return memory;
 
-    MemoryBlock *new_block = malloc(sizeof(MemoryBlock));
+    MemoryBlock *new_block = block_new();
     if (!new_block) return NULL;
 
     // Insert first
@@ -55,7 +120,7 @@ void *mem_alloc_no_lock(size_t size) {
         current = current->next;
     }
 
-    free(new_block);
+    block_release(new_block);
     return NULL;
 }
 
@@ -73,6 +138,175 @@ void *mem_alloc(size_t size) {
     return allocated;
 }
 
+/**
+ * @brief Allocates a block of memory as close as possible to a given address.
+ *
+ * Every large enough gap is considered and the block is placed at the end of
+ * the gap nearest to `hint`, so that blocks used together stay physically
+ * clustered.
+ *
+ * @param hint The address to allocate near, typically a neighbouring block.
+ * @param size The size of the allocated block in bytes.
+ * @return A pointer to the start of the allocated memory, or NULL if the
+ * allocation fails.
+ */
+void *mem_alloc_near(void *hint, size_t size) {
+    pthread_mutex_lock(&lock);
+    if (!memory || size == 0 || hint < memory || hint >= memory + memory_size) {
+        void *allocated = mem_alloc_no_lock(size);
+        pthread_mutex_unlock(&lock);
+        return allocated;
+    }
+
+    void *best = NULL;
+    MemoryBlock **best_link = NULL;
+    size_t best_distance = SIZE_MAX;
+
+    void *gap_start = memory;
+    MemoryBlock **link = &memory_head;
+    for (;;) {
+        void *gap_end = *link ? (*link)->start : memory + memory_size;
+        if (gap_end - gap_start >= size) {
+            // Closest placement of the block within this gap.
+            void *candidate = hint;
+            if (candidate < gap_start) candidate = gap_start;
+            if (candidate > gap_end - size) candidate = gap_end - size;
+            size_t distance =
+                candidate > hint ? candidate - hint : hint - candidate;
+            if (distance < best_distance) {
+                best = candidate;
+                best_link = link;
+                best_distance = distance;
+            }
+        }
+        // Gaps further up only get further away.
+        if (!*link || (gap_end > hint && gap_end - hint >= best_distance))
+            break;
+        gap_start = (*link)->end;
+        link = &(*link)->next;
+    }
+
+    MemoryBlock *new_block = best ? block_new() : NULL;
+    if (!new_block) {
+        pthread_mutex_unlock(&lock);
+        return NULL;
+    }
+    new_block->start = best;
+    new_block->end = best + size;
+    new_block->next = *best_link;
+    *best_link = new_block;
+
+    pthread_mutex_unlock(&lock);
+    return best;
+}
+
+/**
+ * @brief Allocates up to `count` blocks of the specified size in a single pass
+ * over the block list.
+ *
+ * Each block is placed in the first gap at or after the previous one, so a
+ * batch costs one scan instead of one scan per block.
+ *
+ * @param size The size of each allocated block in bytes.
+ * @param count The number of blocks to allocate.
+ * @param blocks An array receiving the start of each allocated block.
+ * @return The number of blocks allocated, which is less than `count` if the
+ * memory ran out.
+ */
+size_t mem_alloc_many(size_t size, size_t count, void **blocks) {
+    if (size == 0 || !blocks) return 0;
+
+    pthread_mutex_lock(&lock);
+    if (!memory) {
+        pthread_mutex_unlock(&lock);
+        return 0;
+    }
+
+    size_t allocated = 0;
+    void *gap_start = memory;
+    MemoryBlock **link = &memory_head;
+    while (allocated < count) {
+        void *gap_end = *link ? (*link)->start : memory + memory_size;
+        if (gap_end - gap_start >= size) {
+            MemoryBlock *new_block = block_new();
+            if (!new_block) break;
+            new_block->start = gap_start;
+            new_block->end = gap_start + size;
+            new_block->next = *link;
+            *link = new_block;
+            blocks[allocated++] = gap_start;
+
+            link = &new_block->next;
+            gap_start = new_block->end;
+            continue;
+        }
+        if (!*link) break;
+        gap_start = (*link)->end;
+        link = &(*link)->next;
+    }
+
+    pthread_mutex_unlock(&lock);
+    return allocated;
+}
+
+/**
+ * @brief Allocates `count` adjacent blocks of the specified size from one
+ * contiguous span, each of which can later be freed on its own.
+ *
+ * @param size The size of each allocated block in bytes.
+ * @param count The number of blocks to allocate.
+ * @param blocks An array receiving the start of each allocated block, in
+ * ascending address order.
+ * @return `count`, or 0 if no gap holds the whole span.
+ */
+size_t mem_alloc_span(size_t size, size_t count, void **blocks) {
+    if (size == 0 || count == 0 || !blocks) return 0;
+
+    pthread_mutex_lock(&lock);
+    if (!memory || size * count > memory_size) {
+        pthread_mutex_unlock(&lock);
+        return 0;
+    }
+
+    // First gap that holds the whole span.
+    void *gap_start = memory;
+    MemoryBlock **link = &memory_head;
+    for (;;) {
+        void *gap_end = *link ? (*link)->start : memory + memory_size;
+        if (gap_end - gap_start >= size * count) break;
+        if (!*link) {
+            pthread_mutex_unlock(&lock);
+            return 0;
+        }
+        gap_start = (*link)->end;
+        link = &(*link)->next;
+    }
+
+    MemoryBlock *first = NULL, **tail = &first;
+    for (size_t i = 0; i < count; i++) {
+        MemoryBlock *new_block = block_new();
+        if (!new_block) {
+            while (first) {
+                MemoryBlock *next = first->next;
+                block_release(first);
+                first = next;
+            }
+            pthread_mutex_unlock(&lock);
+            return 0;
+        }
+        new_block->start = gap_start + i * size;
+        new_block->end = new_block->start + size;
+        blocks[i] = new_block->start;
+        *tail = new_block;
+        tail = &new_block->next;
+    }
+    *tail = *link;
+    *link = first;
+
+    pthread_mutex_unlock(&lock);
+    return count;
+}
+
 void mem_free_no_lock(void *block) {
     if (!block) return;
 
@@ -92,9 +326,17 @@ void mem_free_no_lock(void *block) {
     else
         memory_head = current->next;
 
-    free(current);
+    block_release(current);
 }
 
+/**
+ * @brief Returns the start of the memory pool, against which structures kept
+ * in the pool can store offsets instead of pointers.
+ *
+ * @return A pointer to the first byte of the pool, or NULL before mem_init.
+ */
+void *mem_base() { return memory; }
+
 /**
  * @brief Frees the specified block of memory.
  *
@@ -106,6 +348,43 @@ void mem_free(void *block) {
     pthread_mutex_unlock(&lock);
 }
 
+static int compare_addresses(const void *a, const void *b) {
+    uintptr_t x = (uintptr_t)*(void *const *)a;
+    uintptr_t y = (uintptr_t)*(void *const *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Frees a batch of blocks in a single pass over the block list.
+ *
+ * The addresses are sorted first, so a batch costs one scan instead of one
+ * scan per block. Addresses that are not allocated blocks are ignored.
+ *
+ * @param blocks The starts of the blocks to free; the array is reordered.
+ * @param count The number of blocks.
+ */
+void mem_free_many(void **blocks, size_t count) {
+    if (!blocks || count == 0) return;
+    qsort(blocks, count, sizeof(void *), compare_addresses);
+
+    pthread_mutex_lock(&lock);
+    MemoryBlock **link = &memory_head;
+    size_t i = 0;
+    while (*link && i < count) {
+        if ((uintptr_t)blocks[i] < (uintptr_t)(*link)->start) {
+            i++;
+        } else if (blocks[i] == (*link)->start) {
+            MemoryBlock *freed = *link;
+            *link = freed->next;
+            block_release(freed);
+            i++;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
 /**
  * @brief Changes the size of the memory block, possibly moving it.
  *
@@ -158,13 +437,24 @@ void *mem_resize(void *block, size_t size) {
     }
 
     // Allocation succeeded! Free the old memory and possibly move the memory.
-    free(current);
+    block_release(current);
     size_t new_size = (size <= current_size) ? size : current_size;
     if (new_block != block) memcpy(new_block, block, new_size);
     pthread_mutex_unlock(&lock);
     return new_block;
 }
 
+/**
+ * @brief Frees every block at once in O(1), keeping the pool and the block
+ * descriptors for the allocations that follow.
+ */
+void mem_reset() {
+    pthread_mutex_lock(&lock);
+    memory_head = NULL;
+    block_reset();
+    pthread_mutex_unlock(&lock);
+}
+
 /**
  * @brief Deinitializes the memory manager previously initialized with
  * `mem_init`.
@@ -172,12 +462,15 @@ void *mem_resize(void *block, size_t size) {
 void mem_deinit() {
     pthread_mutex_lock(&lock);
     free(memory);
+    memory = NULL;
+    memory_head = NULL;
 
-    while (memory_head) {
-        MemoryBlock *temp = memory_head;
-        memory_head = memory_head->next;
-        free(temp);
+    while (chunk_first) {
+        BlockChunk *next = chunk_first->next;
+        free(chunk_first);
+        chunk_first = next;
     }
+    block_reset();
 
     memory_size = 0;
     pthread_mutex_unlock(&lock);
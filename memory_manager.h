@@ -11,10 +11,21 @@ typedef struct MemoryBlock {
     struct MemoryBlock *next;
 } MemoryBlock;
 
+// There is one pool per process. The data structures built on it (the
+// sharded, variable-size, compact and packed lists and the hash map) borrow
+// it: the caller sets it up with mem_init before initializing them, their
+// cleanup frees only the blocks they allocated, and the caller tears the pool
+// down with mem_deinit.
 void mem_init(size_t size);
 void *mem_alloc(size_t size);
+void *mem_alloc_near(void *hint, size_t size);
+size_t mem_alloc_many(size_t size, size_t count, void **blocks);
+size_t mem_alloc_span(size_t size, size_t count, void **blocks);
 void mem_free(void *block);
+void mem_free_many(void **blocks, size_t count);
 void *mem_resize(void *block, size_t size);
+void *mem_base();
+void mem_reset();
 void mem_deinit();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,362 @@
+#include "packed_list.h"
+
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Returns the size of a chunk's packed data, with 8 bytes of slack so
+ * that every value can be read with one unaligned 8-byte load.
+ *
+ * @param count The number of values.
+ * @param width The number of bits per value.
+ * @return The size in bytes.
+ */
+static size_t packed_bytes(int count, int width) {
+    return width ? (count * width + 7) / 8 + 8 : 0;
+}
+
+/**
+ * @brief Compresses values into a new chunk allocated from the pool.
+ *
+ * @param values The values to compress.
+ * @param count The number of values, at most PACKED_CHUNK_VALUES.
+ * @return The chunk, or NULL if the allocation failed.
+ */
+static PackedChunk *chunk_pack(const uint16_t *values, int count) {
+    uint16_t min = values[0], max = values[0];
+    for (int i = 1; i < count; i++) {
+        if (values[i] < min) min = values[i];
+        if (values[i] > max) max = values[i];
+    }
+    int width = 0;
+    while ((max - min) >> width) width++;
+
+    // Rounded so that the next chunk header in the pool stays aligned.
+    size_t size = packed_bytes(count, width);
+    PackedChunk *chunk = mem_alloc((sizeof(PackedChunk) + size + 7) & ~7);
+    if (!chunk) return NULL;
+    chunk->next = NULL;
+    chunk->min = min;
+    chunk->max = max;
+    chunk->width = width;
+    chunk->count = count;
+    memset(chunk->bits, 0, size);
+
+    for (int i = 0; width && i < count; i++) {
+        size_t bit = (size_t)i * width;
+        uint64_t word;
+        memcpy(&word, chunk->bits + bit / 8, sizeof(word));
+        word |= (uint64_t)(values[i] - min) << (bit % 8);
+        memcpy(chunk->bits + bit / 8, &word, sizeof(word));
+    }
+    return chunk;
+}
+
+/**
+ * @brief Decompresses every value of a chunk.
+ *
+ * Eight values span exactly `width` bytes, so every group of eight has the
+ * same layout. Up to 9 bits wide, each value lies in the 16 bits starting at
+ * its first byte; with SSE2, one multiply per lane moves the value's top bit
+ * to bit 15, one shift for all lanes drops the bits below it and one add
+ * restores the minimum. SSE2 has no byte shuffle, so the 16-bit windows are
+ * still gathered with scalar loads, and wider values take the scalar loop.
+ *
+ * @param chunk The chunk.
+ * @param values An array of at least PACKED_CHUNK_VALUES receiving the values.
+ */
+static void chunk_unpack(const PackedChunk *chunk, uint16_t *values) {
+    int width = chunk->width;
+    if (width == 0) {
+        for (int i = 0; i < chunk->count; i++) values[i] = chunk->min;
+        return;
+    }
+    int i = 0;
+#ifdef __SSE2__
+    if (width <= 9) {
+        int offsets[8];
+        uint16_t scale[8];
+        for (int j = 0; j < 8; j++) {
+            offsets[j] = j * width / 8;
+            scale[j] = 1u << (16 - width - j * width % 8);
+        }
+        __m128i multiplier = _mm_loadu_si128((const __m128i *)scale);
+        __m128i min = _mm_set1_epi16((short)chunk->min);
+        for (; i + 8 <= chunk->count; i += 8) {
+            const unsigned char *group = chunk->bits + (size_t)i * width / 8;
+            uint16_t window[8];
+            for (int j = 0; j < 8; j++)
+                memcpy(&window[j], group + offsets[j], sizeof(uint16_t));
+            __m128i v = _mm_loadu_si128((const __m128i *)window);
+            v = _mm_srli_epi16(_mm_mullo_epi16(v, multiplier), 16 - width);
+            _mm_storeu_si128((__m128i *)(values + i), _mm_add_epi16(v, min));
+        }
+    }
+#endif
+    uint64_t mask = (1u << width) - 1;
+    for (; i < chunk->count; i++) {
+        size_t bit = (size_t)i * width;
+        uint64_t word;
+        memcpy(&word, chunk->bits + bit / 8, sizeof(word));
+        values[i] = chunk->min + ((word >> (bit % 8)) & mask);
+    }
+}
+
+/**
+ * @brief Finds the first occurrence of a value, comparing eight values per
+ * instruction where SSE2 is available.
+ *
+ * @param values The values to scan.
+ * @param count The number of values.
+ * @param data The value to look for.
+ * @return The index of the first match, or -1.
+ */
+static int find_value(const uint16_t *values, int count, uint16_t data) {
+    int i = 0;
+#ifdef __SSE2__
+    __m128i key = _mm_set1_epi16((short)data);
+    for (; i + 8 <= count; i += 8) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(values + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(block, key));
+        if (mask) return i + __builtin_ctz(mask) / 2;
+    }
+#endif
+    for (; i < count; i++)
+        if (values[i] == data) return i;
+    return -1;
+}
+
+/**
+ * @brief Counts the occurrences of a value, comparing eight values per
+ * instruction where SSE2 is available.
+ *
+ * @param values The values to scan.
+ * @param count The number of values.
+ * @param data The value to count.
+ * @return The number of matches.
+ */
+static int count_value(const uint16_t *values, int count, uint16_t data) {
+    int matches = 0, i = 0;
+#ifdef __SSE2__
+    __m128i key = _mm_set1_epi16((short)data);
+    for (; i + 8 <= count; i += 8) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(values + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(block, key));
+        matches += __builtin_popcount(mask) / 2;
+    }
+#endif
+    for (; i < count; i++) matches += values[i] == data;
+    return matches;
+}
+
+/**
+ * @brief Initializes an empty compressed list.
+ *
+ * @param list A pointer to the list.
+ */
+void packed_list_init(PackedList *list) {
+    list->head = NULL;
+    list->last = NULL;
+    list->tail_count = 0;
+    list->count = 0;
+    pthread_rwlock_init(&list->lock, NULL);
+}
+
+/**
+ * @brief Appends a value, compressing the tail into a chunk once it fills.
+ *
+ * @param list A pointer to the list.
+ * @param data The value to append.
+ * @return 0 on success, -1 if a full tail could not be compressed.
+ */
+int packed_list_insert(PackedList *list, uint16_t data) {
+    pthread_rwlock_wrlock(&list->lock);
+
+    if (list->tail_count == PACKED_CHUNK_VALUES) {
+        PackedChunk *chunk = chunk_pack(list->tail, list->tail_count);
+        if (!chunk) {
+            pthread_rwlock_unlock(&list->lock);
+            return -1;
+        }
+        if (list->last)
+            list->last->next = chunk;
+        else
+            list->head = chunk;
+        list->last = chunk;
+        list->tail_count = 0;
+    }
+    list->tail[list->tail_count++] = data;
+    list->count++;
+
+    pthread_rwlock_unlock(&list->lock);
+    return 0;
+}
+
+/**
+ * @brief Removes the first occurrence of a value, keeping the order of the
+ * others. A chunk holding it is decompressed and packed again one value
+ * shorter, and freed once it is empty.
+ *
+ * @param list A pointer to the list.
+ * @param data The value to remove.
+ * @return 0 on success, -1 if the value is not in the list or the shorter
+ * chunk could not be allocated.
+ */
+int packed_list_delete(PackedList *list, uint16_t data) {
+    pthread_rwlock_wrlock(&list->lock);
+
+    uint16_t values[PACKED_CHUNK_VALUES];
+    PackedChunk *previous = NULL;
+    for (PackedChunk *chunk = list->head; chunk;
+         previous = chunk, chunk = chunk->next) {
+        if (data < chunk->min || data > chunk->max) continue;
+        chunk_unpack(chunk, values);
+        int index = find_value(values, chunk->count, data);
+        if (index < 0) continue;
+
+        int count = chunk->count - 1;
+        memmove(values + index, values + index + 1,
+                (count - index) * sizeof(uint16_t));
+        PackedChunk *shorter = NULL;
+        if (count) {
+            shorter = chunk_pack(values, count);
+            if (!shorter) {
+                pthread_rwlock_unlock(&list->lock);
+                return -1;
+            }
+            shorter->next = chunk->next;
+        }
+        PackedChunk *next = shorter ? shorter : chunk->next;
+        if (previous)
+            previous->next = next;
+        else
+            list->head = next;
+        if (list->last == chunk) list->last = shorter ? shorter : previous;
+        mem_free(chunk);
+        list->count--;
+        pthread_rwlock_unlock(&list->lock);
+        return 0;
+    }
+
+    int index = find_value(list->tail, list->tail_count, data);
+    if (index >= 0) {
+        list->tail_count--;
+        memmove(list->tail + index, list->tail + index + 1,
+                (list->tail_count - index) * sizeof(uint16_t));
+        list->count--;
+    }
+
+    pthread_rwlock_unlock(&list->lock);
+    return index >= 0 ? 0 : -1;
+}
+
+/**
+ * @brief Finds the position of the first occurrence of a value. Chunks whose
+ * range excludes the value are skipped without being decompressed.
+ *
+ * @param list A pointer to the list.
+ * @param data The value to search for.
+ * @return The zero-based position, or -1 if the value is not in the list.
+ */
+long packed_list_search(PackedList *list, uint16_t data) {
+    pthread_rwlock_rdlock(&list->lock);
+
+    uint16_t values[PACKED_CHUNK_VALUES];
+    long position = 0;
+    for (PackedChunk *chunk = list->head; chunk; chunk = chunk->next) {
+        if (data >= chunk->min && data <= chunk->max) {
+            chunk_unpack(chunk, values);
+            int index = find_value(values, chunk->count, data);
+            if (index >= 0) {
+                pthread_rwlock_unlock(&list->lock);
+                return position + index;
+            }
+        }
+        position += chunk->count;
+    }
+    int index = find_value(list->tail, list->tail_count, data);
+
+    pthread_rwlock_unlock(&list->lock);
+    return index >= 0 ? position + index : -1;
+}
+
+/**
+ * @brief Counts the occurrences of a value.
+ *
+ * @param list A pointer to the list.
+ * @param data The value to count.
+ * @return The number of occurrences.
+ */
+size_t packed_list_count_value(PackedList *list, uint16_t data) {
+    pthread_rwlock_rdlock(&list->lock);
+
+    uint16_t values[PACKED_CHUNK_VALUES];
+    size_t matches = 0;
+    for (PackedChunk *chunk = list->head; chunk; chunk = chunk->next) {
+        if (data < chunk->min || data > chunk->max) continue;
+        if (chunk->min == chunk->max) {
+            matches += chunk->count;
+            continue;
+        }
+        chunk_unpack(chunk, values);
+        matches += count_value(values, chunk->count, data);
+    }
+    matches += count_value(list->tail, list->tail_count, data);
+
+    pthread_rwlock_unlock(&list->lock);
+    return matches;
+}
+
+/**
+ * @brief Counts the values in the list.
+ *
+ * @param list A pointer to the list.
+ * @return The number of values.
+ */
+int packed_list_count_nodes(PackedList *list) {
+    pthread_rwlock_rdlock(&list->lock);
+    int count = list->count;
+    pthread_rwlock_unlock(&list->lock);
+    return count;
+}
+
+/**
+ * @brief Returns the memory holding the values: the compressed chunks with
+ * their headers, plus the uncompressed tail.
+ *
+ * @param list A pointer to the list.
+ * @return The size in bytes.
+ */
+size_t packed_list_bytes(PackedList *list) {
+    pthread_rwlock_rdlock(&list->lock);
+
+    size_t bytes = list->tail_count * sizeof(uint16_t);
+    for (PackedChunk *chunk = list->head; chunk; chunk = chunk->next)
+        bytes += sizeof(PackedChunk) + packed_bytes(chunk->count, chunk->width);
+
+    pthread_rwlock_unlock(&list->lock);
+    return bytes;
+}
+
+/**
+ * @brief Frees every chunk of the list.
+ *
+ * @param list A pointer to the list.
+ */
+void packed_list_cleanup(PackedList *list) {
+    pthread_rwlock_wrlock(&list->lock);
+    PackedChunk *chunk = list->head;
+    while (chunk) {
+        PackedChunk *next = chunk->next;
+        mem_free(chunk);
+        chunk = next;
+    }
+    list->head = NULL;
+    list->last = NULL;
+    list->tail_count = 0;
+    list->count = 0;
+    pthread_rwlock_unlock(&list->lock);
+    pthread_rwlock_destroy(&list->lock);
+}
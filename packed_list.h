@@ -0,0 +1,45 @@
+#ifndef PACKED_LIST_H
+#define PACKED_LIST_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory_manager.h"
+
+// Number of values compressed together in one chunk.
+#define PACKED_CHUNK_VALUES 128
+
+// A chunk of values stored as offsets from the chunk minimum, bit-packed at
+// the smallest width that holds the largest offset (frame of reference).
+typedef struct PackedChunk {
+    struct PackedChunk *next;
+    uint16_t min;
+    uint16_t max;
+    uint8_t width;  // Bits per value, 0 when every value equals `min`
+    uint8_t count;  // Number of values, up to PACKED_CHUNK_VALUES
+    unsigned char bits[];
+} PackedChunk;
+
+// A list of uint16_t values that is appended to and scanned. Values collect in
+// an uncompressed tail until a chunk fills up; a delete repacks the one chunk
+// it touches.
+typedef struct {
+    PackedChunk *head;
+    PackedChunk *last;
+    uint16_t tail[PACKED_CHUNK_VALUES];
+    int tail_count;
+    size_t count;
+    pthread_rwlock_t lock;
+} PackedList;
+
+void packed_list_init(PackedList *list);
+int packed_list_insert(PackedList *list, uint16_t data);
+int packed_list_delete(PackedList *list, uint16_t data);
+long packed_list_search(PackedList *list, uint16_t data);
+size_t packed_list_count_value(PackedList *list, uint16_t data);
+int packed_list_count_nodes(PackedList *list);
+size_t packed_list_bytes(PackedList *list);
+void packed_list_cleanup(PackedList *list);
+
+#endif
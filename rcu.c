@@ -0,0 +1,189 @@
+#include "rcu.h"
+
+#include <sched.h>
+#include <stdlib.h>
+
+typedef struct {
+    void *ptr;
+    void (*free_fn)(void *);
+} RcuDeferred;
+
+static RcuReader readers[RCU_MAX_READERS];
+static int reader_limit;  // One past the highest slot ever claimed
+static unsigned long gp_ctr = 1;
+static pthread_mutex_t gp_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static RcuDeferred *deferred;
+static size_t deferred_count;
+static size_t deferred_capacity;
+static pthread_mutex_t defer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread RcuReader *self;
+static __thread int nesting;
+static pthread_key_t exit_key;
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+
+static void reader_exit(void *reader) {
+    __atomic_store_n(&((RcuReader *)reader)->ctr, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&((RcuReader *)reader)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void make_exit_key() { pthread_key_create(&exit_key, reader_exit); }
+
+/**
+ * @brief Claims a reader slot for the calling thread. The slot is released
+ * again when the thread exits.
+ */
+static void reader_register() {
+    pthread_once(&exit_key_once, make_exit_key);
+    for (;;) {
+        for (int i = 0; i < RCU_MAX_READERS; i++) {
+            int expected = 0;
+            if (__atomic_compare_exchange_n(&readers[i].in_use, &expected, 1,
+                                            0, __ATOMIC_ACQ_REL,
+                                            __ATOMIC_RELAXED)) {
+                int limit = __atomic_load_n(&reader_limit, __ATOMIC_RELAXED);
+                while (limit <= i &&
+                       !__atomic_compare_exchange_n(&reader_limit, &limit,
+                                                    i + 1, 0, __ATOMIC_SEQ_CST,
+                                                    __ATOMIC_RELAXED))
+                    ;
+                self = &readers[i];
+                pthread_setspecific(exit_key, self);
+                return;
+            }
+        }
+        sched_yield();  // Every slot is taken, wait for a thread to exit
+    }
+}
+
+/**
+ * @brief Enters a read-side critical section.
+ *
+ * Only the calling thread's own slot is written, with a plain store followed
+ * by a fence: no lock and no atomic read-modify-write. Sections may nest.
+ */
+void rcu_read_lock() {
+    if (!self) reader_register();
+    if (nesting++ > 0) return;
+    __atomic_store_n(&self->ctr, __atomic_load_n(&gp_ctr, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Leaves a read-side critical section.
+ */
+void rcu_read_unlock() {
+    if (--nesting > 0) return;
+    __atomic_store_n(&self->ctr, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Waits until every read-side critical section that was running when
+ * the call started has finished.
+ */
+void synchronize_rcu() {
+    pthread_mutex_lock(&gp_lock);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    unsigned long gp = __atomic_add_fetch(&gp_ctr, 1, __ATOMIC_SEQ_CST);
+
+    int limit = __atomic_load_n(&reader_limit, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < limit; i++) {
+        for (;;) {
+            unsigned long ctr = __atomic_load_n(&readers[i].ctr, __ATOMIC_SEQ_CST);
+            if (ctr == 0 || ctr == gp) break;
+            sched_yield();
+        }
+    }
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&gp_lock);
+}
+
+/**
+ * @brief Frees a batch of deferred pointers after a grace period.
+ *
+ * @param batch The pointers to free.
+ * @param count The number of pointers.
+ */
+static void free_batch(RcuDeferred *batch, size_t count) {
+    if (!count) return;
+    synchronize_rcu();
+    for (size_t i = 0; i < count; i++) batch[i].free_fn(batch[i].ptr);
+}
+
+/**
+ * @brief Queues a pointer to be freed once no reader can still hold a
+ * reference to it.
+ *
+ * Never waits for a grace period itself unless the queue cannot grow, so it
+ * is safe to call with a writer lock held; the caller runs rcu_flush after
+ * dropping that lock. Must not be called inside a read-side critical section.
+ *
+ * @param ptr The pointer to free.
+ * @param free_fn The function releasing the pointer.
+ */
+void rcu_defer_free(void *ptr, void (*free_fn)(void *)) {
+    pthread_mutex_lock(&defer_lock);
+    if (deferred_count == deferred_capacity) {
+        size_t capacity = deferred_capacity ? deferred_capacity * 2
+                                            : RCU_DEFER_BATCH;
+        RcuDeferred *grown = realloc(deferred, capacity * sizeof(RcuDeferred));
+        if (!grown) {
+            // No room to defer, so wait for the readers right here.
+            pthread_mutex_unlock(&defer_lock);
+            synchronize_rcu();
+            free_fn(ptr);
+            return;
+        }
+        deferred = grown;
+        deferred_capacity = capacity;
+    }
+    deferred[deferred_count] = (RcuDeferred){ptr, free_fn};
+    __atomic_store_n(&deferred_count, deferred_count + 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&defer_lock);
+}
+
+/**
+ * @brief Takes every queued free off the queue.
+ *
+ * @param count Receives the number of entries taken.
+ * @return The entries, to be released with free, or NULL.
+ */
+static RcuDeferred *take_deferred(size_t *count) {
+    pthread_mutex_lock(&defer_lock);
+    RcuDeferred *batch = deferred;
+    *count = deferred_count;
+    deferred = NULL;
+    __atomic_store_n(&deferred_count, 0, __ATOMIC_RELAXED);
+    deferred_capacity = 0;
+    pthread_mutex_unlock(&defer_lock);
+    return batch;
+}
+
+/**
+ * @brief Runs the queued frees once a full batch has built up.
+ *
+ * Meant to be called after the caller's writer lock is released, so the
+ * grace period does not hold up other writers. Cheap when there is nothing
+ * to do.
+ */
+void rcu_flush() {
+    if (__atomic_load_n(&deferred_count, __ATOMIC_RELAXED) < RCU_DEFER_BATCH)
+        return;
+    size_t count;
+    RcuDeferred *batch = take_deferred(&count);
+    free_batch(batch, count);
+    free(batch);
+}
+
+/**
+ * @brief Waits for a grace period and runs every pending deferred free.
+ */
+void rcu_barrier() {
+    size_t count;
+    RcuDeferred *batch = take_deferred(&count);
+    free_batch(batch, count);
+    free(batch);
+}
@@ -0,0 +1,25 @@
+#ifndef RCU_H
+#define RCU_H
+
+#include <pthread.h>
+
+// Maximum number of threads registered as readers at the same time.
+#define RCU_MAX_READERS 1024
+// Number of deferred frees queued before rcu_flush waits for a grace period.
+#define RCU_DEFER_BATCH 128
+#define RCU_CACHE_LINE 64
+
+typedef struct {
+    unsigned long ctr;  // Grace period seen on entry, 0 when quiescent
+    int in_use;
+    char pad[RCU_CACHE_LINE - sizeof(unsigned long) - sizeof(int)];
+} __attribute__((aligned(RCU_CACHE_LINE))) RcuReader;
+
+void rcu_read_lock();
+void rcu_read_unlock();
+void synchronize_rcu();
+void rcu_defer_free(void *ptr, void (*free_fn)(void *));
+void rcu_flush();
+void rcu_barrier();
+
+#endif
@@ -0,0 +1,363 @@
+#define _GNU_SOURCE
+#include "replicated_list.h"
+
+#include <sched.h>
+#include <string.h>
+
+/**
+ * @brief Reads the CPUs of a NUMA node from sysfs, given as ranges such as
+ * "0-3,8-11".
+ *
+ * @param node The NUMA node id.
+ * @param cpus Receives the node's CPUs.
+ * @return 0 on success, -1 if the node does not exist.
+ */
+static int node_cpus(int node, cpu_set_t *cpus) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             node);
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+
+    CPU_ZERO(cpus);
+    int first, last;
+    while (fscanf(file, "%d", &first) == 1) {
+        last = first;
+        int c = fgetc(file);
+        if (c == '-') {
+            if (fscanf(file, "%d", &last) != 1) break;
+            c = fgetc(file);
+        }
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, cpus);
+        if (c != ',') break;
+    }
+    fclose(file);
+    return 0;
+}
+
+typedef struct {
+    Replica *replica;
+    size_t capacity;
+} SlabRequest;
+
+static void *slab_touch(void *arg) {
+    SlabRequest *request = arg;
+    Replica *replica = request->replica;
+    replica->slab = malloc(request->capacity * sizeof(Node));
+    if (replica->slab) memset(replica->slab, 0, request->capacity * sizeof(Node));
+    return NULL;
+}
+
+/**
+ * @brief Allocates a replica's nodes from a thread running on the replica's
+ * CPUs, so that first-touch placement puts them in local memory.
+ *
+ * @param replica The replica.
+ * @param capacity The number of nodes.
+ * @param cpus The CPUs reading the replica; may be empty.
+ */
+static void slab_alloc_local(Replica *replica, size_t capacity,
+                             cpu_set_t *cpus) {
+    SlabRequest request = {.replica = replica, .capacity = capacity};
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    if (CPU_COUNT(cpus)) pthread_attr_setaffinity_np(&attr, sizeof(*cpus), cpus);
+    if (pthread_create(&thread, &attr, slab_touch, &request) == 0)
+        pthread_join(thread, NULL);
+    else
+        slab_touch(&request);
+    pthread_attr_destroy(&attr);
+}
+
+/**
+ * @brief Initializes a list replicated once per NUMA node.
+ *
+ * Topology is read from sysfs; without it there is a single replica.
+ * Forcing more replicas than NUMA nodes spreads the CPUs over them
+ * round-robin, forcing fewer groups nodes together.
+ *
+ * @param list A pointer to the list.
+ * @param num_replicas The number of replicas, or 0 for one per NUMA node.
+ * @param size The size in bytes to allocate for the nodes of each replica.
+ * @return 0 on success, -1 if the replicas could not be allocated.
+ */
+int replicated_list_init(ReplicatedList *list, int num_replicas, size_t size) {
+    cpu_set_t node_cpu_sets[REPLICATED_LIST_MAX_REPLICAS];
+    int num_nodes = 0;
+    for (int node = 0; node < REPLICATED_LIST_MAX_REPLICAS; node++)
+        if (node_cpus(node, &node_cpu_sets[num_nodes]) == 0) num_nodes++;
+
+    if (num_replicas <= 0) num_replicas = num_nodes ? num_nodes : 1;
+    if (num_replicas > REPLICATED_LIST_MAX_REPLICAS)
+        num_replicas = REPLICATED_LIST_MAX_REPLICAS;
+
+    for (int cpu = 0; cpu < REPLICATED_LIST_MAX_CPUS; cpu++) {
+        int node = 0;
+        for (int i = 0; i < num_nodes; i++)
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &node_cpu_sets[i])) node = i;
+        list->cpu_replica[cpu] = num_replicas <= num_nodes
+                                     ? node % num_replicas
+                                     : cpu % num_replicas;
+    }
+
+    list->replicas =
+        aligned_alloc(REPLICATED_LIST_CACHE_LINE, num_replicas * sizeof(Replica));
+    if (!list->replicas) return -1;
+    list->num_replicas = num_replicas;
+    list->log_tail = 0;
+    pthread_mutex_init(&list->log_lock, NULL);
+
+    size_t capacity = size / sizeof(Node);
+    for (int r = 0; r < num_replicas; r++) {
+        Replica *replica = &list->replicas[r];
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu = 0; cpu < REPLICATED_LIST_MAX_CPUS && cpu < CPU_SETSIZE;
+             cpu++)
+            if (list->cpu_replica[cpu] == r) CPU_SET(cpu, &cpus);
+
+        replica->head = NULL;
+        replica->tail = NULL;
+        replica->count = 0;
+        replica->capacity = capacity;
+        replica->slab_used = 0;
+        replica->free_nodes = NULL;
+        replica->applied = 0;
+        pthread_rwlock_init(&replica->lock, NULL);
+        slab_alloc_local(replica, capacity, &cpus);
+        if (!replica->slab && capacity) {
+            // Replicas of different capacities would drift apart.
+            list->num_replicas = r + 1;
+            replicated_list_cleanup(list);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Replays one logged write on a replica. The caller must hold the
+ * replica's lock for writing.
+ *
+ * @param replica The replica.
+ * @param entry The write to replay.
+ */
+static void replica_apply(Replica *replica, const LogEntry *entry) {
+    if (entry->op == LIST_OP_INSERT) {
+        Node *node = replica->free_nodes;
+        if (node)
+            replica->free_nodes = node->next;
+        else if (replica->slab_used < replica->capacity)
+            node = &replica->slab[replica->slab_used++];
+        else
+            return;  // Not reached: inserts are logged only if there is room.
+        node->data = entry->data;
+        node->flags = 0;
+        node->next = NULL;
+        if (replica->tail)
+            replica->tail->next = node;
+        else
+            replica->head = node;
+        replica->tail = node;
+        replica->count++;
+        return;
+    }
+
+    Node *previous = NULL;
+    Node *current = replica->head;
+    while (current && current->data != entry->data) {
+        previous = current;
+        current = current->next;
+    }
+    if (!current) return;
+    if (previous)
+        previous->next = current->next;
+    else
+        replica->head = current->next;
+    if (replica->tail == current) replica->tail = previous;
+    current->next = replica->free_nodes;
+    replica->free_nodes = current;
+    replica->count--;
+}
+
+/**
+ * @brief Replays every logged write a replica has not seen yet. The caller
+ * must hold the replica's lock for writing.
+ *
+ * @param list A pointer to the list.
+ * @param replica The replica.
+ */
+static void replica_catch_up(ReplicatedList *list, Replica *replica) {
+    size_t tail = __atomic_load_n(&list->log_tail, __ATOMIC_ACQUIRE);
+    size_t applied = replica->applied;
+    for (; applied < tail; applied++)
+        replica_apply(replica, &list->log[applied % REPLICATED_LIST_LOG_SIZE]);
+    __atomic_store_n(&replica->applied, applied, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Returns the replica of the NUMA node the calling thread runs on.
+ *
+ * @param list A pointer to the list.
+ * @return The replica.
+ */
+static Replica *local_replica(ReplicatedList *list) {
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= REPLICATED_LIST_MAX_CPUS) cpu = 0;
+    return &list->replicas[list->cpu_replica[cpu]];
+}
+
+/**
+ * @brief Read-locks the local replica, replaying pending writes first.
+ *
+ * @param list A pointer to the list.
+ * @return The locked replica.
+ */
+static Replica *replica_read_lock(ReplicatedList *list) {
+    Replica *replica = local_replica(list);
+    pthread_rwlock_rdlock(&replica->lock);
+    if (__atomic_load_n(&replica->applied, __ATOMIC_ACQUIRE) <
+        __atomic_load_n(&list->log_tail, __ATOMIC_ACQUIRE)) {
+        pthread_rwlock_unlock(&replica->lock);
+        pthread_rwlock_wrlock(&replica->lock);
+        replica_catch_up(list, replica);
+        pthread_rwlock_unlock(&replica->lock);
+        pthread_rwlock_rdlock(&replica->lock);
+    }
+    return replica;
+}
+
+/**
+ * @brief Appends a write to the shared log and applies it to the local
+ * replica. Other replicas replay it when they are next read, or here if the
+ * log is about to overwrite an entry they have not replayed.
+ *
+ * An insert is refused before it is logged if the replicas have no room for
+ * it. All replicas replay the same writes into slabs of the same capacity,
+ * so one replica brought up to date tells for all of them.
+ *
+ * @param list A pointer to the list.
+ * @param op LIST_OP_INSERT or LIST_OP_DELETE.
+ * @param data The data of the write.
+ * @return 0 on success, -1 if the list is full.
+ */
+static int replicated_list_write(ReplicatedList *list, uint8_t op,
+                                 uint16_t data) {
+    pthread_mutex_lock(&list->log_lock);
+
+    Replica *replica = local_replica(list);
+    if (op == LIST_OP_INSERT) {
+        pthread_rwlock_wrlock(&replica->lock);
+        replica_catch_up(list, replica);
+        int full = (size_t)replica->count >= replica->capacity;
+        pthread_rwlock_unlock(&replica->lock);
+        if (full) {
+            pthread_mutex_unlock(&list->log_lock);
+            return -1;
+        }
+    }
+
+    size_t tail = list->log_tail;
+    for (int r = 0; r < list->num_replicas; r++) {
+        Replica *replica = &list->replicas[r];
+        if (__atomic_load_n(&replica->applied, __ATOMIC_ACQUIRE) +
+                REPLICATED_LIST_LOG_SIZE >
+            tail)
+            continue;
+        pthread_rwlock_wrlock(&replica->lock);
+        replica_catch_up(list, replica);
+        pthread_rwlock_unlock(&replica->lock);
+    }
+    list->log[tail % REPLICATED_LIST_LOG_SIZE] = (LogEntry){.op = op,
+                                                           .data = data};
+    __atomic_store_n(&list->log_tail, tail + 1, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&list->log_lock);
+
+    pthread_rwlock_wrlock(&replica->lock);
+    replica_catch_up(list, replica);
+    pthread_rwlock_unlock(&replica->lock);
+    return 0;
+}
+
+/**
+ * @brief Inserts the specified data at the end of every replica.
+ *
+ * @param list A pointer to the list.
+ * @param data The data to insert.
+ * @return 0 on success, -1 if the replicas have no room for another node.
+ */
+int replicated_list_insert(ReplicatedList *list, uint16_t data) {
+    return replicated_list_write(list, LIST_OP_INSERT, data);
+}
+
+/**
+ * @brief Removes the first node with the specified data from every replica.
+ *
+ * @param list A pointer to the list.
+ * @param data The data to remove.
+ */
+void replicated_list_delete(ReplicatedList *list, uint16_t data) {
+    replicated_list_write(list, LIST_OP_DELETE, data);
+}
+
+/**
+ * @brief Searches the local replica for the specified data.
+ *
+ * @param list A pointer to the list.
+ * @param data The data to search for.
+ * @return 1 if the data is in the list, 0 otherwise.
+ */
+int replicated_list_search(ReplicatedList *list, uint16_t data) {
+    Replica *replica = replica_read_lock(list);
+    Node *current = replica->head;
+    while (current && current->data != data) current = current->next;
+    pthread_rwlock_unlock(&replica->lock);
+    return current != NULL;
+}
+
+/**
+ * @brief Counts the nodes of the local replica.
+ *
+ * @param list A pointer to the list.
+ * @return The number of nodes in the list.
+ */
+int replicated_list_count_nodes(ReplicatedList *list) {
+    Replica *replica = replica_read_lock(list);
+    int count = replica->count;
+    pthread_rwlock_unlock(&replica->lock);
+    return count;
+}
+
+/**
+ * @brief Brings every replica up to date with the log, for instance before a
+ * burst of reads.
+ *
+ * @param list A pointer to the list.
+ */
+void replicated_list_sync(ReplicatedList *list) {
+    for (int r = 0; r < list->num_replicas; r++) {
+        Replica *replica = &list->replicas[r];
+        pthread_rwlock_wrlock(&replica->lock);
+        replica_catch_up(list, replica);
+        pthread_rwlock_unlock(&replica->lock);
+    }
+}
+
+/**
+ * @brief Frees every replica.
+ *
+ * @param list A pointer to the list.
+ */
+void replicated_list_cleanup(ReplicatedList *list) {
+    for (int r = 0; r < list->num_replicas; r++) {
+        free(list->replicas[r].slab);
+        pthread_rwlock_destroy(&list->replicas[r].lock);
+    }
+    free(list->replicas);
+    list->replicas = NULL;
+    list->num_replicas = 0;
+    pthread_mutex_destroy(&list->log_lock);
+}
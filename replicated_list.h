@@ -0,0 +1,51 @@
+#ifndef REPLICATED_LIST_H
+#define REPLICATED_LIST_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "linked_list.h"
+
+#define REPLICATED_LIST_MAX_REPLICAS 64
+#define REPLICATED_LIST_MAX_CPUS 1024
+#define REPLICATED_LIST_LOG_SIZE 1024  // Entries in the shared operation log
+#define REPLICATED_LIST_CACHE_LINE 64
+
+// A write recorded in the shared log, replayed by every replica.
+typedef struct {
+    uint8_t op;  // LIST_OP_INSERT or LIST_OP_DELETE
+    uint16_t data;
+} LogEntry;
+
+// One copy of the list, kept in memory local to the CPUs that read it.
+typedef struct {
+    Node *head;
+    Node *tail;
+    int count;
+    Node *slab;        // Nodes of this replica, first touched locally
+    size_t capacity;   // Nodes in the slab
+    size_t slab_used;  // Nodes handed out from the slab so far
+    Node *free_nodes;  // Deleted nodes, linked by `next`
+    size_t applied;    // Log entries replayed so far
+    pthread_rwlock_t lock;
+} __attribute__((aligned(REPLICATED_LIST_CACHE_LINE))) Replica;
+
+typedef struct {
+    Replica *replicas;
+    int num_replicas;
+    LogEntry log[REPLICATED_LIST_LOG_SIZE];
+    size_t log_tail;  // Entries ever appended to the log
+    pthread_mutex_t log_lock;
+    uint8_t cpu_replica[REPLICATED_LIST_MAX_CPUS];
+} ReplicatedList;
+
+int replicated_list_init(ReplicatedList *list, int num_replicas, size_t size);
+int replicated_list_insert(ReplicatedList *list, uint16_t data);
+void replicated_list_delete(ReplicatedList *list, uint16_t data);
+int replicated_list_search(ReplicatedList *list, uint16_t data);
+int replicated_list_count_nodes(ReplicatedList *list);
+void replicated_list_sync(ReplicatedList *list);
+void replicated_list_cleanup(ReplicatedList *list);
+
+#endif
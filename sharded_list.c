@@ -0,0 +1,220 @@
+#include "sharded_list.h"
+
+/**
+ * @brief Returns the shard holding the specified data.
+ *
+ * @param list A pointer to the sharded list.
+ * @param data The data to look up.
+ * @return A pointer to the shard.
+ */
+static ListShard *shard_of(ShardedList *list, uint16_t data) {
+    // Multiplicative hashing spreads runs of nearby values over the shards.
+    uint32_t hash = ((uint32_t)data * 2654435761u) >> 16;
+    return &list->shards[hash % list->num_shards];
+}
+
+/**
+ * @brief Takes a node from the shard's free nodes, refilling them from the
+ * pool with one batch allocation when they run out. The shard's lock must be
+ * held.
+ *
+ * @param shard A pointer to the shard.
+ * @return A pointer to the node, or NULL if the pool is full.
+ */
+static Node *shard_take_node(ListShard *shard) {
+    if (!shard->free_nodes) {
+        Node *nodes[SHARDED_LIST_BATCH];
+        size_t allocated =
+            mem_alloc_many(sizeof(Node), SHARDED_LIST_BATCH, (void **)nodes);
+        for (size_t i = 0; i < allocated; i++) {
+            nodes[i]->next = shard->free_nodes;
+            shard->free_nodes = nodes[i];
+        }
+        shard->num_free += allocated;
+    }
+
+    Node *node = shard->free_nodes;
+    if (node) {
+        shard->free_nodes = node->next;
+        shard->num_free--;
+    }
+    return node;
+}
+
+/**
+ * @brief Initializes a sharded list, whose nodes are kept in unordered
+ * sub-lists chosen by hashing their data.
+ *
+ * @param list A pointer to the sharded list.
+ * @param num_shards The number of sub-lists, each with its own lock.
+ */
+void sharded_list_init(ShardedList *list, int num_shards) {
+    if (num_shards < 1) num_shards = 1;
+    if (num_shards > SHARDED_LIST_MAX_SHARDS)
+        num_shards = SHARDED_LIST_MAX_SHARDS;
+
+    list->shards = aligned_alloc(SHARDED_LIST_CACHE_LINE,
+                                 num_shards * sizeof(ListShard));
+    list->num_shards = list->shards ? num_shards : 0;
+    for (int i = 0; i < list->num_shards; i++) {
+        list->shards[i].head = NULL;
+        list->shards[i].count = 0;
+        list->shards[i].free_nodes = NULL;
+        list->shards[i].num_free = 0;
+        pthread_rwlock_init(&list->shards[i].lock, NULL);
+    }
+}
+
+/**
+ * @brief Inserts the specified data at the front of its shard.
+ *
+ * @param list A pointer to the sharded list.
+ * @param data The data to insert into the list.
+ */
+void sharded_list_insert(ShardedList *list, uint16_t data) {
+    ListShard *shard = shard_of(list, data);
+    pthread_rwlock_wrlock(&shard->lock);
+
+    Node *new_node = shard_take_node(shard);
+    if (!new_node) {
+        pthread_rwlock_unlock(&shard->lock);
+        return;
+    }
+    new_node->data = data;
+    new_node->flags = 0;
+    new_node->next = shard->head;
+    shard->head = new_node;
+    shard->count++;
+    pthread_rwlock_unlock(&shard->lock);
+}
+
+/**
+ * @brief Removes a node with the specified data from its shard.
+ *
+ * @param list A pointer to the sharded list.
+ * @param data The data to remove from the list.
+ */
+void sharded_list_delete(ShardedList *list, uint16_t data) {
+    ListShard *shard = shard_of(list, data);
+    pthread_rwlock_wrlock(&shard->lock);
+
+    Node **link = &shard->head;
+    while (*link && (*link)->data != data) link = &(*link)->next;
+    Node *temp = *link;
+    if (temp) {
+        *link = temp->next;
+        shard->count--;
+        temp->next = shard->free_nodes;
+        shard->free_nodes = temp;
+        shard->num_free++;
+    }
+
+    // Past two batches of free nodes, one batch goes back to the pool.
+    Node *released[SHARDED_LIST_BATCH];
+    size_t num_released = 0;
+    if (shard->num_free > 2 * SHARDED_LIST_BATCH) {
+        while (num_released < SHARDED_LIST_BATCH) {
+            released[num_released++] = shard->free_nodes;
+            shard->free_nodes = shard->free_nodes->next;
+        }
+        shard->num_free -= num_released;
+    }
+
+    pthread_rwlock_unlock(&shard->lock);
+    if (num_released) mem_free_many((void **)released, num_released);
+}
+
+/**
+ * @brief Searches the shard of the specified data for a matching node.
+ *
+ * @param list A pointer to the sharded list.
+ * @param data The data to search for.
+ * @return A pointer to a matching node, or NULL if there is none.
+ */
+Node *sharded_list_search(ShardedList *list, uint16_t data) {
+    ListShard *shard = shard_of(list, data);
+    pthread_rwlock_rdlock(&shard->lock);
+
+    Node *current = shard->head;
+    while (current && current->data != data) current = current->next;
+
+    pthread_rwlock_unlock(&shard->lock);
+    return current;
+}
+
+/**
+ * @brief Prints all elements of the list, shard by shard.
+ *
+ * Each shard is printed under its own lock, so the output is not a snapshot
+ * of the whole list while writers are running.
+ *
+ * @param list A pointer to the sharded list.
+ */
+void sharded_list_display(ShardedList *list) {
+    int first = 1;
+    printf("[");
+    for (int i = 0; i < list->num_shards; i++) {
+        pthread_rwlock_rdlock(&list->shards[i].lock);
+        for (Node *current = list->shards[i].head; current;
+             current = current->next) {
+            printf(first ? "%d" : ", %d", current->data);
+            first = 0;
+        }
+        pthread_rwlock_unlock(&list->shards[i].lock);
+    }
+    printf("]");
+}
+
+/**
+ * @brief Counts the nodes of all shards.
+ *
+ * @param list A pointer to the sharded list.
+ * @return The number of nodes in the list.
+ */
+int sharded_list_count_nodes(ShardedList *list) {
+    int count = 0;
+    for (int i = 0; i < list->num_shards; i++) {
+        pthread_rwlock_rdlock(&list->shards[i].lock);
+        count += list->shards[i].count;
+        pthread_rwlock_unlock(&list->shards[i].lock);
+    }
+    return count;
+}
+
+/**
+ * @brief Frees all the nodes and shards of the list.
+ *
+ * The nodes of every shard, linked or free, are returned to the pool with
+ * one call to mem_free_many.
+ *
+ * @param list A pointer to the sharded list.
+ */
+void sharded_list_cleanup(ShardedList *list) {
+    size_t total = 0;
+    for (int i = 0; i < list->num_shards; i++)
+        total += list->shards[i].count + list->shards[i].num_free;
+
+    Node **nodes = malloc(total * sizeof(Node *));
+    size_t count = 0;
+    for (int i = 0; i < list->num_shards; i++) {
+        Node *chains[2] = {list->shards[i].head, list->shards[i].free_nodes};
+        for (int j = 0; j < 2; j++) {
+            Node *current = chains[j];
+            while (current) {
+                Node *next = current->next;
+                if (nodes)
+                    nodes[count++] = current;
+                else
+                    mem_free(current);
+                current = next;
+            }
+        }
+        pthread_rwlock_destroy(&list->shards[i].lock);
+    }
+    if (nodes) mem_free_many((void **)nodes, count);
+    free(nodes);
+
+    free(list->shards);
+    list->shards = NULL;
+    list->num_shards = 0;
+}
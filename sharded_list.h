@@ -0,0 +1,39 @@
+#ifndef SHARDED_LIST_H
+#define SHARDED_LIST_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "linked_list.h"
+
+#define SHARDED_LIST_MAX_SHARDS 256
+#define SHARDED_LIST_CACHE_LINE 64
+// Nodes a shard takes from or returns to the pool at once.
+#define SHARDED_LIST_BATCH 32
+
+// One sub-list with its own lock, padded so that shards locked by different
+// threads never share a cache line. Each shard keeps the nodes it deleted for
+// its next inserts, so only one insert or delete in SHARDED_LIST_BATCH goes
+// through the pool lock.
+typedef struct {
+    Node *head;
+    int count;
+    Node *free_nodes;
+    int num_free;
+    pthread_rwlock_t lock;
+} __attribute__((aligned(SHARDED_LIST_CACHE_LINE))) ListShard;
+
+typedef struct {
+    ListShard *shards;
+    int num_shards;
+} ShardedList;
+
+void sharded_list_init(ShardedList *list, int num_shards);
+void sharded_list_insert(ShardedList *list, uint16_t data);
+void sharded_list_delete(ShardedList *list, uint16_t data);
+Node *sharded_list_search(ShardedList *list, uint16_t data);
+void sharded_list_display(ShardedList *list);
+int sharded_list_count_nodes(ShardedList *list);
+void sharded_list_cleanup(ShardedList *list);
+
+#endif
@@ -4,10 +4,19 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "common_defs.h"
 #include "gitdata.h"
+#include "hash_map.h"
 #include "linked_list.h"
+#include "rcu.h"
+#include "compact_list.h"
+#include "intrusive_list.h"
+#include "packed_list.h"
+#include "replicated_list.h"
+#include "sharded_list.h"
+#include "var_list.h"
 
 typedef struct {
     Node **head;  // Pointer to the head of the linked list
@@ -20,8 +29,25 @@ typedef struct {
 typedef struct {
     int num_threads;
     int num_nodes;
+    Node **head;  // A list set up by the caller and emptied after the test,
+                  // or NULL for a list of the test's own
 } TestParams;
 
+// Empties a list the caller set up for the test, or frees the test's own.
+void test_list_done(TestParams *params, Node **head) {
+    if (params->head)
+        list_reset(head);
+    else
+        list_cleanup(head);
+}
+
+// Checks that a cleanup gave every block back to a pool of the given size.
+void assert_pool_empty(size_t size) {
+    void *whole = mem_alloc(size);
+    my_assert(whole != NULL);
+    mem_free(whole);
+}
+
 // Function to capture stdout output.
 void capture_stdout(char *buffer, size_t size,
                     void (*func)(Node **, Node *, Node *), Node **head,
@@ -73,8 +99,9 @@ void test_list_insert_multithread(TestParams *params) {
     printf_yellow("  Testing list_insert (threads: %d, nodes: %d) ---> ",
                   params->num_threads, params->num_nodes);
 
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * params->num_nodes);
+    Node *own_head = NULL;
+    Node **head = params->head ? params->head : &own_head;
+    if (!params->head) list_init(head, sizeof(Node) * params->num_nodes);
 
     pthread_t *threads = malloc(params->num_threads * sizeof(pthread_t));
     thread_data_t *thread_data =
@@ -82,7 +109,7 @@ void test_list_insert_multithread(TestParams *params) {
     int nodes_per_thread = params->num_nodes / params->num_threads;
     // Initialize threads and data structures
     for (int i = 0; i < params->num_threads; i++) {
-        thread_data[i].head = &head;
+        thread_data[i].head = head;
         thread_data[i].start_value = i * nodes_per_thread;
         thread_data[i].num_nodes = nodes_per_thread;
         if (pthread_create(&threads[i], NULL, thread_insert_function,
@@ -96,12 +123,12 @@ void test_list_insert_multithread(TestParams *params) {
         pthread_join(threads[i], NULL);
     }
 
-    my_assert(list_count_nodes(&head) == params->num_nodes);
+    my_assert(list_count_nodes(head) == params->num_nodes);
     // Verify and clean up
     // Note: Verification can be complex in multithreaded contexts due to node
     // order variations
     printf_green("[PASS].\n");
-    list_cleanup(&head);
+    test_list_done(params, head);
 
     free(threads);
     free(thread_data);
@@ -119,10 +146,12 @@ void test_list_insert_after_multithread(TestParams *params) {
     printf_yellow("  Testing list_insert_after (threads: %d, nodes: %d) ---> ",
                   params->num_threads, params->num_nodes);
 
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) *
-                         (params->num_nodes + 1));  // +1 for the initial node
-    list_insert(&head, 10);  // Initial node to insert after
+    Node *own_head = NULL;
+    Node **head = params->head ? params->head : &own_head;
+    if (!params->head)
+        list_init(head, sizeof(Node) *
+                            (params->num_nodes + 1));  // +1 for the initial node
+    list_insert(head, 10);  // Initial node to insert after
 
     pthread_t *threads = malloc(params->num_threads * sizeof(pthread_t));
     thread_data_t *thread_data =
@@ -131,8 +160,8 @@ void test_list_insert_after_multithread(TestParams *params) {
 
     // Initialize threads and data structures
     for (int i = 0; i < params->num_threads; i++) {
-        thread_data[i].head = &head;
-        thread_data[i].prev_node = head;  // Always insert after the first node
+        thread_data[i].head = head;
+        thread_data[i].prev_node = *head;  // Always insert after the first node
         thread_data[i].start_value = i * nodes_per_thread;
         thread_data[i].num_nodes = nodes_per_thread;
         if (pthread_create(&threads[i], NULL, thread_insert_after_function,
@@ -147,11 +176,11 @@ void test_list_insert_after_multithread(TestParams *params) {
     }
 
     // Verify node count
-    my_assert(list_count_nodes(&head) ==
+    my_assert(list_count_nodes(head) ==
               params->num_nodes + 1);  // +1 for the initial node
 
     // Cleanup and pass message
-    list_cleanup(&head);
+    test_list_done(params, head);
     free(threads);
     free(thread_data);
     printf_green("[PASS].\n");
@@ -175,19 +204,20 @@ void test_list_insert_before_multithreaded(TestParams *params) {
         "  Testing list_insert_before with %d threads, each inserting %d nodes "
         "---> ",
         params->num_threads, params->num_nodes);
-    Node *head = NULL;
-    list_init(&head,
-              sizeof(Node) * (params->num_threads +
-                              params->num_nodes + 1));  // Allocate enough space
+    Node *own_head = NULL;
+    Node **head = params->head ? params->head : &own_head;
+    if (!params->head)  // Allocate enough space
+        list_init(head, sizeof(Node) * (params->num_threads +
+                                        params->num_nodes + 1));
 
     Node **nodes = malloc(sizeof(Node *) * (params->num_threads +
                                             1));  // Array of pointers to Node
-    list_insert(&head, 0);  // Insert the initial head node
-    nodes[0] = head;        // Save head node pointer
+    list_insert(head, 0);  // Insert the initial head node
+    nodes[0] = *head;       // Save head node pointer
 
     // Insert additional nodes to serve as insertion targets
     for (int i = 1; i <= params->num_threads; i++) {
-        list_insert(&head, i * 10);     // Sequentially increasing data
+        list_insert(head, i * 10);      // Sequentially increasing data
         nodes[i] = nodes[i - 1]->next;  // Save pointer to the newly added node
     }
 
@@ -196,7 +226,7 @@ void test_list_insert_before_multithreaded(TestParams *params) {
 
     // Set up thread data and create threads for inserting nodes
     for (int i = 0; i < params->num_threads; i++) {
-        thread_data[i].head = &head;
+        thread_data[i].head = head;
         thread_data[i].prev_node =
             nodes[i];  // Each thread starts at a different initial node
         thread_data[i].num_nodes =
@@ -213,8 +243,8 @@ void test_list_insert_before_multithreaded(TestParams *params) {
     // Optional: Verify the list structure, node count, etc.
     int expected_count = params->num_threads + params->num_nodes +
                          1;  // Initial nodes + inserted nodes + head
-    my_assert(list_count_nodes(&head) == expected_count);
-    list_cleanup(&head);
+    my_assert(list_count_nodes(head) == expected_count);
+    test_list_done(params, head);
 
     free(nodes);  // Free the dynamically allocated nodes array
     printf_green("[PASS].\n");
@@ -235,12 +265,15 @@ void *thread_delete_function(void *arg) {
 void test_list_delete_multithreaded(TestParams *params) {
     printf_yellow("  Testing list_delete with %d threads, nodes: %d ---> ",
                   params->num_threads, params->num_nodes);
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * (params->num_threads * params->num_nodes));
+    Node *own_head = NULL;
+    Node **head = params->head ? params->head : &own_head;
+    if (!params->head)
+        list_init(head,
+                  sizeof(Node) * (params->num_threads * params->num_nodes));
 
     // Insert nodes into the list
     for (int i = 0; i < params->num_nodes; i++) {
-        list_insert(&head, i);  // Ensure unique values for simplicity
+        list_insert(head, i);  // Ensure unique values for simplicity
     }
 
     pthread_t *threads = malloc(params->num_threads * sizeof(pthread_t));
@@ -250,7 +283,7 @@ void test_list_delete_multithreaded(TestParams *params) {
 
     // Initialize threads and their respective data
     for (int i = 0; i < params->num_threads; i++) {
-        thread_data[i].head = &head;
+        thread_data[i].head = head;
         thread_data[i].num_nodes = nodes_per_thread;
         thread_data[i].thread_id = i;
         pthread_create(&threads[i], NULL, thread_delete_function,
@@ -263,12 +296,12 @@ void test_list_delete_multithreaded(TestParams *params) {
     }
 
     // Verify the remaining list is empty if all nodes were to be deleted
-    my_assert(list_count_nodes(&head) ==
+    my_assert(list_count_nodes(head) ==
               0);  // Assuming all nodes are supposed to be deleted
 
     printf_green("[PASS].\n");
 
-    list_cleanup(&head);
+    test_list_done(params, head);
     free(threads);
     free(thread_data);
 }
@@ -505,11 +538,1316 @@ void test_list_cleanup() {
     list_insert(&head, 20);
     list_insert(&head, 30);
 
+    // A reset empties the list and hands the whole pool back at once.
+    list_reset(&head);
+    my_assert(head == NULL);
+    for (int i = 0; i < 3; i++) list_insert(&head, i);
+    my_assert(list_count_nodes(&head) == 3 && head->data == 0);
+
     list_cleanup(&head);
     my_assert(head == NULL);
     printf_green("[PASS].\n");
 }
 
+void test_list_save_load(int count) {
+    printf_yellow("  Testing list_save and list_load (nodes: %d) ---> ", count);
+    char path[] = "/tmp/test_list_save_loadXXXXXX";
+    int fd = mkstemp(path);
+    my_assert(fd >= 0);
+    close(fd);
+
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * count);
+    list_insert(&head, 0);
+    for (int i = 1; i < count; i++) list_insert_after(head, i);
+    my_assert(list_save(&head, path) == 0);
+    list_cleanup(&head);
+
+    // Load into a fresh list that already holds one node.
+    list_init(&head, sizeof(Node) * (count + 1));
+    list_insert(&head, 12345);
+    my_assert(list_load(&head, path) == 0);
+    my_assert(list_count_nodes(&head) == count + 1);
+
+    Node *current = head->next;
+    my_assert(current->data == 0);
+    current = current->next;
+    for (int i = count - 1; i > 0; i--) {
+        my_assert(current->data == i);
+        current = current->next;
+    }
+    my_assert(current == NULL);
+
+    // A pool too small for the file leaves the list unchanged.
+    list_cleanup(&head);
+    list_init(&head, sizeof(Node) * (count / 2));
+    my_assert(list_load(&head, path) == -1);
+    my_assert(head == NULL);
+    my_assert(list_load(&head, "/nonexistent/list.bin") == -1);
+
+    list_cleanup(&head);
+    unlink(path);
+    printf_green("[PASS].\n");
+}
+
+uint64_t sum_data(uint64_t acc, uint16_t data) { return acc + data; }
+
+uint64_t sum_partials(uint64_t a, uint64_t b) { return a + b; }
+
+void test_list_parallel_traversal(int count) {
+    printf_yellow("  Testing parallel traversal (nodes: %d) ---> ", count);
+    list_set_parallelism(4, 64);
+
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * (count + count / 2));
+    uint64_t sum = 0;
+    for (int i = 0; i < count; i++) {
+        list_insert(&head, i % 1000);
+        sum += i % 1000;
+    }
+
+    my_assert(list_count_nodes(&head) == count);
+    my_assert(list_reduce(&head, sum_data, sum_partials, 0) == sum);
+
+    // Searches must return the first matching node.
+    Node *found = list_search(&head, 999);
+    my_assert(found && found->data == 999);
+    Node *current = head;
+    for (int i = 0; i < 999; i++) current = current->next;
+    my_assert(found == current);
+    my_assert(list_search(&head, 1000) == NULL);
+
+    // Deleting nodes (including segment anchors) and inserting in the middle
+    // must keep the results exact.
+    for (int i = 0; i < 200; i++) {
+        list_delete(&head, i);
+        sum -= i;
+    }
+    for (int i = 0; i < count / 2; i++) {
+        list_insert_after(head, 1000 + i % 7);
+        sum += 1000 + i % 7;
+    }
+    my_assert(list_count_nodes(&head) == count - 200 + count / 2);
+    my_assert(list_reduce(&head, sum_data, sum_partials, 0) == sum);
+    found = list_search(&head, 150);
+    my_assert(found && found->data == 150);
+
+    list_cleanup(&head);
+    list_set_parallelism(0, 0);
+    printf_green("[PASS].\n");
+}
+
+void *thread_rcu_reader(void *arg) {
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < 2000; i++) {
+        // Base nodes are never deleted, so they must always be found.
+        Node *found = list_search(data->head, i % data->num_nodes);
+        my_assert(found && found->data == i % data->num_nodes);
+        my_assert(list_count_nodes(data->head) >= data->num_nodes);
+    }
+    return NULL;
+}
+
+void *thread_rcu_writer(void *arg) {
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < 500; i++) {
+        list_insert(data->head, data->start_value + i % 16);
+        list_delete(data->head, data->start_value + i % 16);
+    }
+    return NULL;
+}
+
+void test_list_rcu(TestParams *params) {
+    printf_yellow("  Testing RCU read path (threads: %d, nodes: %d) ---> ",
+                  params->num_threads, params->num_nodes);
+    int num_writers = params->num_threads / 2;
+
+    // Leave room for the nodes waiting for a grace period.
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * (params->num_nodes + num_writers * 16 +
+                                     2 * RCU_DEFER_BATCH));
+    list_set_rcu(1);
+    for (int i = 0; i < params->num_nodes; i++) list_insert(&head, i);
+
+    pthread_t threads[params->num_threads];
+    thread_data_t thread_data[params->num_threads];
+    for (int i = 0; i < params->num_threads; i++) {
+        thread_data[i].head = &head;
+        thread_data[i].num_nodes = params->num_nodes;
+        thread_data[i].start_value = 1000 + i * 16;
+        pthread_create(&threads[i], NULL,
+                       i < num_writers ? thread_rcu_writer : thread_rcu_reader,
+                       &thread_data[i]);
+    }
+    for (int i = 0; i < params->num_threads; i++)
+        pthread_join(threads[i], NULL);
+
+    my_assert(list_count_nodes(&head) == params->num_nodes);
+    list_set_rcu(0);
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+typedef struct {
+    ShardedList *list;
+    int start_value;
+    int num_nodes;
+} shard_thread_data_t;
+
+void *thread_sharded_insert(void *arg) {
+    shard_thread_data_t *data = (shard_thread_data_t *)arg;
+    for (int i = 0; i < data->num_nodes; i++)
+        sharded_list_insert(data->list, data->start_value + i);
+    return NULL;
+}
+
+void *thread_sharded_delete(void *arg) {
+    shard_thread_data_t *data = (shard_thread_data_t *)arg;
+    for (int i = 0; i < data->num_nodes; i++) {
+        Node *found = sharded_list_search(data->list, data->start_value + i);
+        my_assert(found && found->data == data->start_value + i);
+        sharded_list_delete(data->list, data->start_value + i);
+    }
+    return NULL;
+}
+
+void test_sharded_list_multithread(TestParams *params) {
+    printf_yellow("  Testing sharded list (threads: %d, nodes: %d) ---> ",
+                  params->num_threads, params->num_nodes);
+    ShardedList list;
+    // Every shard may hold back up to a batch of free nodes.
+    size_t pool_size =
+        sizeof(Node) * (params->num_nodes + 16 * SHARDED_LIST_BATCH);
+    mem_init(pool_size);
+    sharded_list_init(&list, 16);
+
+    pthread_t threads[params->num_threads];
+    shard_thread_data_t thread_data[params->num_threads];
+    int nodes_per_thread = params->num_nodes / params->num_threads;
+    for (int i = 0; i < params->num_threads; i++) {
+        thread_data[i].list = &list;
+        thread_data[i].start_value = i * nodes_per_thread;
+        thread_data[i].num_nodes = nodes_per_thread;
+        pthread_create(&threads[i], NULL, thread_sharded_insert,
+                       &thread_data[i]);
+    }
+    for (int i = 0; i < params->num_threads; i++)
+        pthread_join(threads[i], NULL);
+    my_assert(sharded_list_count_nodes(&list) ==
+              nodes_per_thread * params->num_threads);
+
+    for (int i = 0; i < params->num_threads; i++)
+        pthread_create(&threads[i], NULL, thread_sharded_delete,
+                       &thread_data[i]);
+    for (int i = 0; i < params->num_threads; i++)
+        pthread_join(threads[i], NULL);
+    my_assert(sharded_list_count_nodes(&list) == 0);
+    my_assert(sharded_list_search(&list, 0) == NULL);
+    // Deletes hand free nodes beyond two batches back to the pool.
+    for (int i = 0; i < list.num_shards; i++)
+        my_assert(list.shards[i].num_free <= 2 * SHARDED_LIST_BATCH);
+
+    for (int i = 0; i < 8; i++) sharded_list_insert(&list, i);
+    sharded_list_cleanup(&list);
+    assert_pool_empty(pool_size);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+typedef struct {
+    uint16_t key;
+    int owner;
+    ListLink link;
+} Item;
+
+typedef struct {
+    IntrusiveList *list;
+    Item *items;
+    int thread_id;
+    int num_items;
+} ilist_thread_data_t;
+
+int item_has_key(const ListLink *link, const void *key) {
+    return ilist_entry(link, Item, link)->key == *(const uint16_t *)key;
+}
+
+void *thread_ilist_link(void *arg) {
+    ilist_thread_data_t *data = (ilist_thread_data_t *)arg;
+    for (int i = 0; i < data->num_items; i++) {
+        data->items[i].key = data->thread_id * data->num_items + i;
+        data->items[i].owner = data->thread_id;
+        if (i % 2)
+            ilist_push_back(data->list, &data->items[i].link);
+        else
+            ilist_push_front(data->list, &data->items[i].link);
+    }
+    return NULL;
+}
+
+void *thread_ilist_unlink(void *arg) {
+    ilist_thread_data_t *data = (ilist_thread_data_t *)arg;
+    for (int i = 0; i < data->num_items; i++) {
+        ListLink *found = ilist_find(data->list, item_has_key,
+                                     &data->items[i].key);
+        my_assert(found == &data->items[i].link);
+        ilist_remove(data->list, &data->items[i].link);
+    }
+    return NULL;
+}
+
+void test_intrusive_list_multithread(TestParams *params) {
+    printf_yellow("  Testing intrusive list (threads: %d, items: %d) ---> ",
+                  params->num_threads, params->num_nodes);
+    int items_per_thread = params->num_nodes / params->num_threads;
+
+    // The items live in the pool; linking them allocates nothing more.
+    mem_init(sizeof(Item) * params->num_nodes);
+    IntrusiveList list;
+    ilist_init(&list);
+
+    pthread_t threads[params->num_threads];
+    ilist_thread_data_t thread_data[params->num_threads];
+    for (int i = 0; i < params->num_threads; i++) {
+        thread_data[i].list = &list;
+        thread_data[i].items = mem_alloc(sizeof(Item) * items_per_thread);
+        thread_data[i].thread_id = i;
+        thread_data[i].num_items = items_per_thread;
+        pthread_create(&threads[i], NULL, thread_ilist_link, &thread_data[i]);
+    }
+    for (int i = 0; i < params->num_threads; i++)
+        pthread_join(threads[i], NULL);
+    my_assert(ilist_count(&list) == items_per_thread * params->num_threads);
+
+    // Every object reached through the list is one of ours.
+    ListLink *link;
+    int seen = 0;
+    ilist_rdlock(&list);
+    ilist_for_each(&list, link) {
+        Item *item = ilist_entry(link, Item, link);
+        my_assert(item->key / items_per_thread == item->owner);
+        seen++;
+    }
+    ilist_unlock(&list);
+    my_assert(seen == items_per_thread * params->num_threads);
+
+    for (int i = 0; i < params->num_threads; i++)
+        pthread_create(&threads[i], NULL, thread_ilist_unlink,
+                       &thread_data[i]);
+    for (int i = 0; i < params->num_threads; i++)
+        pthread_join(threads[i], NULL);
+    my_assert(ilist_count(&list) == 0);
+    my_assert(ilist_pop_front(&list) == NULL);
+
+    // Several unlocked updates under one write lock, including removal while
+    // iterating.
+    ListLink *next;
+    ilist_wrlock(&list);
+    for (int i = 0; i < items_per_thread; i++)
+        ilist_push_back_no_lock(&list, &thread_data[0].items[i].link);
+    ilist_for_each_safe(&list, link, next) {
+        if (ilist_entry(link, Item, link)->key % 2)
+            ilist_remove_no_lock(&list, link);
+    }
+    my_assert(list.count == (size_t)(items_per_thread + 1) / 2);
+    while (ilist_pop_front_no_lock(&list)) continue;
+    ilist_unlock(&list);
+    my_assert(ilist_count(&list) == 0);
+
+    ilist_destroy(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+typedef struct {
+    uint32_t id;
+    char name[];
+} Record;
+
+int record_has_name(const void *payload, size_t size, const void *key) {
+    return strcmp(((const Record *)payload)->name, key);
+}
+
+void test_var_list(int count) {
+    printf_yellow("  Testing list with inline payloads (nodes: %d) ---> ",
+                  count);
+    VarList list;
+    size_t pool_size = count * (sizeof(VarNode) + 96);
+    mem_init(pool_size);
+    var_list_init(&list, sizeof(uint32_t), sizeof(uint32_t));
+
+    // Records of different sizes, each stored in one allocation. Blocks of
+    // other sizes in between leave the nodes' blocks at odd addresses.
+    char buffer[64] __attribute__((aligned(16)));
+    Record *record = (Record *)buffer;
+    void **spacers = malloc(count * sizeof(void *));
+    for (int i = 0; i < count; i++) {
+        spacers[i] = mem_alloc(1 + i % 23);
+        record->id = i;
+        int length = sprintf(record->name, "record-%d", i * 7);
+        VarNode *node =
+            var_list_insert(&list, record, sizeof(Record) + length + 1);
+        my_assert(node && node->size == sizeof(Record) + length + 1);
+        my_assert((uintptr_t)node->payload % 16 == 0);
+    }
+    my_assert(var_list_count_nodes(&list) == count);
+    mem_free_many(spacers, count);
+    free(spacers);
+
+    // Keyed on the id prefix, or on the name through a comparator.
+    uint32_t id = count / 2;
+    VarNode *found = var_list_search(&list, &id);
+    my_assert(found && ((Record *)found->payload)->id == id);
+    sprintf(buffer, "record-%d", 7 * (count - 1));
+    found = var_list_find(&list, record_has_name, buffer);
+    my_assert(found && ((Record *)found->payload)->id == count - 1);
+    my_assert(var_list_find(&list, record_has_name, "missing") == NULL);
+
+    // Inserts of size 0 use the list's payload size.
+    id = count;
+    my_assert(var_list_insert(&list, &id, 0)->size == sizeof(uint32_t));
+
+    for (id = 0; id <= count; id++) var_list_delete(&list, &id);
+    my_assert(var_list_count_nodes(&list) == 0);
+    my_assert(list.tail == NULL);
+
+    for (id = 0; id < 8; id++) var_list_insert(&list, &id, 0);
+    var_list_cleanup(&list);
+    assert_pool_empty(pool_size);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+int list_has_values(Node *head, int first, int count) {
+    Node *previous = NULL;
+    for (int i = 0; i < count; i++, head = head->next) {
+        if (!head || head->data != first + i) return 0;
+#ifdef LIST_DOUBLY_LINKED
+        if (head->prev != previous) return 0;
+#endif
+        previous = head;
+    }
+    return head == NULL;
+}
+
+void test_list_relinearize(int count) {
+    printf_yellow("  Testing list relinearization (nodes: %d) ---> ", count);
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 3 * count);
+
+    // Build the list back to front so it runs against the pool.
+    list_insert(&head, count - 1);
+    for (int i = count - 2; i >= 0; i--) list_insert_before(&head, head, i);
+    my_assert(list_has_values(head, 0, count));
+
+    my_assert(list_relinearize(&head) == 0);
+    my_assert(list_has_values(head, 0, count));
+    for (Node *current = head; current->next; current = current->next)
+        my_assert(current < current->next);
+
+    // A pass of steps ends with a short step and keeps the order.
+    size_t moved, steps = 0;
+    while ((moved = list_relinearize_step(&head, count / 8)) == count / 8)
+        steps++;
+    my_assert(steps == 8 && moved == 0);
+    my_assert(list_relinearize_step(&head, count) == count);
+    my_assert(list_has_values(head, 0, count));
+    my_assert(list_count_nodes(&head) == count);
+
+    // The background pass runs alongside readers and leaves pinned nodes
+    // where they are.
+    Node *pinned = list_pin(&head, count / 2);
+    my_assert(pinned && pinned->data == count / 2);
+    my_assert(list_relinearize_start(&head, 64, 100) == 0);
+    my_assert(list_relinearize_start(&head, 64, 100) == -1);
+    for (int i = 0; i < 64; i++)
+        my_assert(list_search(&head, i * (count / 64)) != NULL);
+    usleep(10000);
+    list_relinearize_stop();
+    my_assert(list_has_values(head, 0, count));
+    my_assert(list_search(&head, count / 2) == pinned);
+    my_assert(list_relinearize(&head) == 0);
+    my_assert(list_search(&head, count / 2) == pinned);
+    list_unpin(pinned);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_splice_split(int count) {
+    printf_yellow("  Testing list_splice, list_split and list_concat ---> ");
+    int quarter = count / 4;
+    Node *a = NULL, *b = NULL, *c = NULL;
+    list_init(&a, sizeof(Node) * count);
+    for (int i = 0; i < count; i++) list_insert(&a, i);
+
+    // Small segments so that the counts below run in parallel.
+    list_set_parallelism(4, 64);
+    list_split(&a, list_search(&a, quarter - 1), &b);
+    list_split(&b, list_search(&b, 3 * quarter - 1), &c);
+    my_assert(list_has_values(a, 0, quarter));
+    my_assert(list_has_values(b, quarter, 2 * quarter));
+    my_assert(list_has_values(c, 3 * quarter, count - 3 * quarter));
+    my_assert(list_count_nodes(&a) == quarter);
+
+    // A split never overwrites a list holding nodes.
+    list_split(&a, NULL, &b);
+    my_assert(list_count_nodes(&a) == quarter);
+
+    // Put the pieces back in order, splicing one into the middle.
+    list_concat(&a, &c);
+    list_splice(&a, list_search(&a, quarter - 1), &b);
+    my_assert(b == NULL && c == NULL);
+    my_assert(list_has_values(a, 0, count));
+    my_assert(list_count_nodes(&a) == count);
+
+    // Detaching and splicing back the whole list.
+    list_split(&a, NULL, &b);
+    my_assert(a == NULL && list_has_values(b, 0, count));
+    list_splice(&a, NULL, &b);
+    my_assert(list_has_values(a, 0, count));
+    my_assert(list_search(&a, count - 1) != NULL);
+    my_assert(list_count_nodes(&a) == count);
+    list_set_parallelism(0, 0);
+
+    list_cleanup(&a);
+    printf_green("[PASS].\n");
+}
+
+int compare_descending(uint16_t a, uint16_t b) { return (int)b - (int)a; }
+
+// Checks the order of the list, and that equal values kept the order of
+// their (ascending) allocation.
+int list_is_sorted(Node *head, int descending) {
+    Node *previous = NULL;
+    for (Node *current = head; current; current = current->next) {
+#ifdef LIST_DOUBLY_LINKED
+        if (current->prev != previous) return 0;
+#endif
+        if (previous) {
+            int order = descending ? previous->data - current->data
+                                   : current->data - previous->data;
+            if (order < 0 || (order == 0 && current < previous)) return 0;
+        }
+        previous = current;
+    }
+    return 1;
+}
+
+typedef struct {
+    Node **head;
+    int count;
+    volatile int stop;
+    int mismatches;
+} sort_reader_data_t;
+
+void *thread_sort_reader(void *arg) {
+    sort_reader_data_t *data = (sort_reader_data_t *)arg;
+    while (!__atomic_load_n(&data->stop, __ATOMIC_ACQUIRE))
+        if (list_count_nodes(data->head) != data->count) data->mismatches++;
+    return NULL;
+}
+
+void test_list_sort(int count) {
+    printf_yellow("  Testing list_sort (nodes: %d) ---> ", count);
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * count);
+    for (int i = 0; i < count; i++) list_insert(&head, rand() % (count / 8));
+    uint64_t sum = list_reduce(&head, sum_data, sum_partials, 0);
+
+    list_sort(&head, NULL);
+    my_assert(list_is_sorted(head, 0));
+
+    // Sorting chunks on workers, with an odd number of chunks to merge.
+    for (int workers = 2; workers <= 5; workers++) {
+        list_set_parallelism(workers, 64);
+        list_sort(&head, compare_descending);
+        my_assert(list_is_sorted(head, 1));
+        list_sort(&head, NULL);
+        my_assert(list_is_sorted(head, 0));
+    }
+    my_assert(list_count_nodes(&head) == count);
+    my_assert(list_reduce(&head, sum_data, sum_partials, 0) == sum);
+    list_set_parallelism(0, 0);
+
+    // Lock-free readers never see a node twice or miss one mid-sort.
+    list_set_rcu(1);
+    sort_reader_data_t reader = {.head = &head, .count = count};
+    pthread_t thread;
+    pthread_create(&thread, NULL, thread_sort_reader, &reader);
+    for (int i = 0; i < 16; i++)
+        list_sort(&head, i % 2 ? NULL : compare_descending);
+    __atomic_store_n(&reader.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+    my_assert(reader.mismatches == 0);
+    list_set_rcu(0);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+#ifdef LIST_JUMP_POINTERS
+int list_jumps_are_exact(Node *head) {
+    for (Node *current = head; current; current = current->next) {
+        Node *target = current;
+        for (int i = 0; i < LIST_JUMP_DISTANCE && target; i++)
+            target = target->next;
+        if (current->jump != target) return 0;
+    }
+    return 1;
+}
+#endif
+
+void test_list_jump_pointers(int count) {
+    printf_yellow("  Testing list jump pointers (nodes: %d) ---> ", count);
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 2 * count);
+    for (int i = 0; i < count; i++) list_insert(&head, 2 * i);
+#ifdef LIST_JUMP_POINTERS
+    my_assert(list_jumps_are_exact(head));
+#endif
+
+    // Inserts and deletes in the middle leave the links approximate.
+    for (Node *current = head; current; current = current->next->next)
+        list_insert_after(current, current->data + 1);
+    for (int i = 0; i < count; i += 4) list_delete(&head, 2 * i + 1);
+    list_update_jumps(&head);
+#ifdef LIST_JUMP_POINTERS
+    my_assert(list_jumps_are_exact(head));
+#endif
+
+    int expected = 2 * count - count / 4;
+    my_assert(list_count_nodes(&head) == expected);
+    my_assert(list_search(&head, 2 * count - 1) != NULL);
+    my_assert(list_search(&head, 1) == NULL);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void *thread_hot_search(void *arg) {
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < data->num_nodes; i++) {
+        // Mostly a handful of hot values, sometimes any value.
+        uint16_t value = i % 4 ? data->start_value + i % 8 : rand() % 1024;
+        my_assert(list_search(data->head, value)->data == value);
+    }
+    return NULL;
+}
+
+void test_list_self_organizing(int count) {
+    printf_yellow("  Testing self-organizing search and finger search ---> ");
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * count);
+    for (int i = 0; i < count; i++) list_insert(&head, i);
+
+    // A finger search walks on from the hint and wraps to the head.
+    Node *hint = list_search(&head, count / 2);
+    my_assert(list_search_from(&head, hint, count / 2 + 3)->data ==
+              count / 2 + 3);
+    my_assert(list_search_from(&head, hint, 1)->data == 1);
+    my_assert(list_search_from(&head, hint, count) == NULL);
+    my_assert(list_search_from(&head, NULL, 5)->data == 5);
+    my_assert(list_has_values(head, 0, count));
+
+    // A hint that is not on the list ends the wrapped walk at the tail.
+    Node stray = {.data = UINT16_MAX, .next = NULL};
+    my_assert(list_search_from(&head, &stray, count) == NULL);
+
+    // Transposing moves a node one step per hit.
+    list_set_self_organizing(LIST_ORGANIZE_TRANSPOSE);
+    for (int i = 0; i < 3; i++) list_search(&head, 3);
+    my_assert(head->data == 3);
+    my_assert(head->next->data == 0 && head->next->next->next->data == 2);
+    list_search(&head, 3);
+    my_assert(head->data == 3);
+
+    // Moving to the front puts the last hit first.
+    list_set_self_organizing(LIST_ORGANIZE_MOVE_TO_FRONT);
+    Node *found = list_search(&head, count - 1);
+    my_assert(head == found && found->data == count - 1);
+#ifdef LIST_DOUBLY_LINKED
+    my_assert(head->prev == NULL && head->next->prev == head);
+#endif
+
+    // Nodes keep moving safely while several threads search.
+    int num_threads = 4;
+    pthread_t threads[num_threads];
+    thread_data_t thread_data[num_threads];
+    for (int i = 0; i < num_threads; i++) {
+        thread_data[i].head = &head;
+        thread_data[i].start_value = 100 * i;
+        thread_data[i].num_nodes = 1000;
+        pthread_create(&threads[i], NULL, thread_hot_search, &thread_data[i]);
+    }
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+
+    // Nodes stay in place in RCU mode, also for searches that fall back to
+    // the lock while list_sort shuts the lock-free readers out.
+    list_set_rcu(1);
+    sort_reader_data_t reader = {.head = &head, .count = count};
+    pthread_t reader_thread;
+    pthread_create(&reader_thread, NULL, thread_sort_reader, &reader);
+    for (int i = 0; i < num_threads; i++) {
+        thread_data[i].num_nodes = 20000;
+        pthread_create(&threads[i], NULL, thread_hot_search, &thread_data[i]);
+    }
+    for (int i = 0; i < 64; i++) list_sort(&head, NULL);
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    __atomic_store_n(&reader.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(reader_thread, NULL);
+    my_assert(reader.mismatches == 0);
+    list_set_rcu(0);
+    list_set_self_organizing(LIST_ORGANIZE_NONE);
+
+    my_assert(list_count_nodes(&head) == count);
+    my_assert(list_reduce(&head, sum_data, sum_partials, 0) ==
+              (uint64_t)count * (count - 1) / 2);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_search_many(int count, int num_keys) {
+    printf_yellow("  Testing list_search_many (nodes: %d, keys: %d) ---> ",
+                  count, num_keys);
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * count);
+    for (int i = 0; i < count; i++) list_insert(&head, 3 * i);
+
+    // Present, absent and repeated keys, checked against list_search.
+    uint16_t keys[num_keys];
+    Node *results[num_keys];
+    for (int i = 0; i < num_keys; i++) keys[i] = rand() % (4 * count);
+    keys[num_keys - 1] = keys[0];
+    for (int rcu = 0; rcu <= 1; rcu++) {
+        list_set_rcu(rcu);
+        size_t expected = 0;
+        size_t found = list_search_many(&head, keys, num_keys, results);
+        for (int i = 0; i < num_keys; i++) {
+            my_assert(results[i] == list_search(&head, keys[i]));
+            expected += results[i] != NULL;
+        }
+        my_assert(found == expected);
+    }
+    list_set_rcu(0);
+
+    my_assert(list_search_many(&head, keys, 0, results) == 0);
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_apply(int count) {
+    printf_yellow("  Testing list_apply (nodes: %d) ---> ", count);
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * (count + 4));
+
+    ListOp ops[count];
+    for (int i = 0; i < count; i++)
+        ops[i] = (ListOp){.op = LIST_OP_INSERT, .data = i};
+    my_assert(list_apply(&head, ops, count) == count);
+    my_assert(list_has_values(head, 0, count));
+    my_assert(ops[count - 1].result->data == count - 1);
+
+    // A mixed batch; the last three operations have nothing to act on.
+    Node *five = list_search(&head, 5);
+    ListOp mixed[] = {
+        {.op = LIST_OP_DELETE, .data = 0},
+        {.op = LIST_OP_SEARCH, .data = 5},
+        {.op = LIST_OP_INSERT_AFTER, .node = five, .data = 1000},
+        {.op = LIST_OP_INSERT, .data = 2000},
+        {.op = LIST_OP_DELETE, .data = count - 1},
+        {.op = LIST_OP_INSERT, .data = 3000},
+        {.op = LIST_OP_DELETE, .data = 9999},
+        {.op = LIST_OP_SEARCH, .data = 0},
+        {.op = LIST_OP_INSERT_AFTER, .node = NULL, .data = 1},
+    };
+    my_assert(list_apply(&head, mixed, 9) == 6);
+    my_assert(mixed[1].result == five && mixed[2].result == five->next);
+    my_assert(mixed[6].result == NULL && mixed[7].result == NULL);
+    my_assert(head->data == 1 && head->next->next->next->next == five);
+    my_assert(list_count_nodes(&head) == count + 1);
+    Node *current = five->next;
+    my_assert(current->data == 1000 && current->next->data == 6);
+    while (current->next->next) current = current->next;
+    my_assert(current->data == 2000 && current->next->data == 3000);
+
+    // Inserts beyond the pool fail, and deletes work in RCU mode.
+    for (int i = 0; i < 8; i++)
+        ops[i] = (ListOp){.op = LIST_OP_INSERT, .data = 4000 + i};
+    my_assert(list_apply(&head, ops, 8) == 3);
+    my_assert(ops[2].result != NULL && ops[3].result == NULL);
+    list_set_rcu(1);
+    for (int i = 0; i < 3; i++)
+        ops[i] = (ListOp){.op = LIST_OP_DELETE, .data = 4000 + i};
+    my_assert(list_apply(&head, ops, 3) == 3);
+    list_set_rcu(0);
+    my_assert(list_count_nodes(&head) == count + 1);
+
+    // An insert after a node the same batch deleted fails.
+    Node *six = list_search(&head, 6);
+    ListOp stale[] = {{.op = LIST_OP_DELETE, .data = 6},
+                      {.op = LIST_OP_INSERT_AFTER, .node = six, .data = 5000}};
+    my_assert(list_apply(&head, stale, 2) == 1);
+    my_assert(stale[0].result == six && stale[1].result == NULL);
+    my_assert(list_search(&head, 5000) == NULL);
+    my_assert(list_count_nodes(&head) == count);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+typedef struct {
+    PackedList *list;
+    int iterations;
+} packed_thread_data_t;
+
+void *thread_packed_scan(void *arg) {
+    packed_thread_data_t *data = (packed_thread_data_t *)arg;
+    for (int i = 0; i < data->iterations; i++) {
+        // Appends only add values from 60000 on.
+        size_t before = packed_list_count_value(data->list, 60000);
+        my_assert(packed_list_count_value(data->list, 60000) >= before);
+        my_assert(packed_list_search(data->list, 0) == 0);
+    }
+    return NULL;
+}
+
+void test_packed_list(int count) {
+    printf_yellow("  Testing compressed list (values: %d) ---> ", count);
+    PackedList list;
+    mem_init(4 * count + 8192);
+    packed_list_init(&list);
+
+    // A slowly varying signal compresses to a few bits per value.
+    uint16_t *values = malloc(count * sizeof(uint16_t));
+    int value = 0;
+    for (int i = 0; i < count; i++) {
+        values[i] = value;
+        my_assert(packed_list_insert(&list, value) == 0);
+        value += rand() % 9 - 4;
+        if (value < 0) value = 0;
+    }
+    my_assert(packed_list_count_nodes(&list) == count);
+    my_assert(packed_list_bytes(&list) < (size_t)count * 3 / 2);
+
+    // Searches and counts agree with a plain scan of the same values.
+    for (int probe = 0; probe < 64; probe++) {
+        uint16_t key = values[rand() % count] + probe % 2;
+        long first = -1;
+        size_t matches = 0;
+        for (int i = 0; i < count; i++) {
+            if (values[i] != key) continue;
+            if (first < 0) first = i;
+            matches++;
+        }
+        my_assert(packed_list_search(&list, key) == first);
+        my_assert(packed_list_count_value(&list, key) == matches);
+    }
+    my_assert(packed_list_search(&list, 65535) == -1);
+
+    // Deletes remove the first occurrence and keep the order of the rest.
+    // The leading value stays, for the scans below.
+    int length = count;
+    for (int probe = 0; probe < 64; probe++) {
+        uint16_t key = values[1 + rand() % (length - 1)];
+        if (key == values[0]) continue;
+        int first = 0;
+        while (values[first] != key) first++;
+        memmove(values + first, values + first + 1,
+                (length - first - 1) * sizeof(uint16_t));
+        length--;
+        my_assert(packed_list_delete(&list, key) == 0);
+        int next = 0;
+        while (next < length && values[next] != key) next++;
+        my_assert(packed_list_search(&list, key) == (next < length ? next : -1));
+    }
+    my_assert(packed_list_delete(&list, 65535) == -1);
+    my_assert(packed_list_count_nodes(&list) == length);
+
+    // Every width unpacks to the values packed, both where it fits the
+    // vector path and where it does not. A second list shares the pool.
+    PackedList widths;
+    packed_list_init(&widths);
+    uint16_t packed[16 * PACKED_CHUNK_VALUES];
+    for (int width = 1; width <= 16; width++) {
+        for (int i = 0; i < PACKED_CHUNK_VALUES; i++) {
+            uint16_t v = i == 1 ? (1u << width) - 1
+                                : (i * 2654435761u >> 9) & ((1u << width) - 1);
+            packed[(width - 1) * PACKED_CHUNK_VALUES + i] = v;
+            packed_list_insert(&widths, v);
+        }
+    }
+    for (int k = 0; k < 16 * PACKED_CHUNK_VALUES; k += 7) {
+        int first = 0;
+        while (packed[first] != packed[k]) first++;
+        my_assert(packed_list_search(&widths, packed[k]) == first);
+    }
+    packed_list_cleanup(&widths);
+
+    // Scans run alongside appends of values spanning the full width.
+    int num_threads = 4;
+    pthread_t threads[num_threads];
+    packed_thread_data_t thread_data = {.list = &list, .iterations = 32};
+    for (int i = 0; i < num_threads; i++)
+        pthread_create(&threads[i], NULL, thread_packed_scan, &thread_data);
+    for (int i = 0; i < count / 4; i++)
+        packed_list_insert(&list, i % 2 ? 60000 : 60000 - rand() % 60000);
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    my_assert(packed_list_count_value(&list, 60000) >= (size_t)count / 8);
+    my_assert(packed_list_count_nodes(&list) == length + count / 4);
+
+    free(values);
+    packed_list_cleanup(&list);
+    assert_pool_empty(4 * count + 8192);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+typedef struct {
+    ReplicatedList *list;
+    int start_value;
+    int num_nodes;
+} replicated_thread_data_t;
+
+void *thread_replicated_write(void *arg) {
+    replicated_thread_data_t *data = (replicated_thread_data_t *)arg;
+    for (int i = 0; i < data->num_nodes; i++) {
+        my_assert(replicated_list_insert(data->list, data->start_value + i) ==
+                  0);
+        my_assert(replicated_list_search(data->list, data->start_value + i));
+        if (i % 4 == 3) replicated_list_delete(data->list, data->start_value + i);
+    }
+    return NULL;
+}
+
+void test_replicated_list(int num_threads, int count) {
+    printf_yellow("  Testing replicated list (threads: %d, nodes: %d) ---> ",
+                  num_threads, count);
+    ReplicatedList list;
+
+    // One replica per NUMA node, or a single one without NUMA.
+    my_assert(replicated_list_init(&list, 0, sizeof(Node) * 16) == 0);
+    my_assert(list.num_replicas >= 1);
+    my_assert(replicated_list_insert(&list, 1) == 0);
+    my_assert(replicated_list_search(&list, 1));
+    replicated_list_cleanup(&list);
+
+    // A full list refuses inserts instead of letting replicas drop them, and
+    // takes them again once a delete makes room.
+    my_assert(replicated_list_init(&list, 2, sizeof(Node) * 4) == 0);
+    for (int i = 0; i < 4; i++) my_assert(replicated_list_insert(&list, i) == 0);
+    my_assert(replicated_list_insert(&list, 4) == -1);
+    replicated_list_delete(&list, 0);
+    my_assert(replicated_list_insert(&list, 5) == 0);
+    replicated_list_sync(&list);
+    for (int r = 0; r < list.num_replicas; r++)
+        my_assert(list.replicas[r].count == 4);
+    my_assert(!replicated_list_search(&list, 4));
+    replicated_list_cleanup(&list);
+
+    // Forced replicas; the writes overrun the log several times.
+    my_assert(replicated_list_init(&list, 4, sizeof(Node) * count) == 0);
+    my_assert(list.num_replicas == 4);
+    pthread_t threads[num_threads];
+    replicated_thread_data_t thread_data[num_threads];
+    int per_thread = count / num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        thread_data[i] = (replicated_thread_data_t){
+            .list = &list, .start_value = i * per_thread, .num_nodes = per_thread};
+        pthread_create(&threads[i], NULL, thread_replicated_write,
+                       &thread_data[i]);
+    }
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+
+    int expected = num_threads * (per_thread - per_thread / 4);
+    my_assert(replicated_list_count_nodes(&list) == expected);
+    replicated_list_sync(&list);
+    Node *reference = list.replicas[0].head;
+    for (int r = 0; r < list.num_replicas; r++) {
+        my_assert(list.replicas[r].count == expected);
+        Node *a = reference;
+        Node *b = list.replicas[r].head;
+        while (a && b && a->data == b->data) {
+            a = a->next;
+            b = b->next;
+        }
+        my_assert(a == NULL && b == NULL);
+    }
+    my_assert(!replicated_list_search(&list, 3));
+    my_assert(replicated_list_search(&list, 2));
+
+    replicated_list_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+typedef struct {
+    HashMap *map;
+    int start_key;
+    int num_keys;
+} hash_thread_data_t;
+
+void *thread_hash_put(void *arg) {
+    hash_thread_data_t *data = (hash_thread_data_t *)arg;
+    for (int i = 0; i < data->num_keys; i++) {
+        uint16_t key = data->start_key + i;
+        void *expected = (void *)(uintptr_t)(key + 1);
+        my_assert(hash_map_put(data->map, key, expected) == 0);
+        void *value = NULL;
+        my_assert(hash_map_get(data->map, key, &value) && value == expected);
+    }
+    return NULL;
+}
+
+void test_hash_map(int num_threads, int count) {
+    printf_yellow("  Testing hash map (threads: %d, keys: %d) ---> ",
+                  num_threads, count);
+    // A pool too small for the first buckets fails the init.
+    HashMap map;
+    mem_init(sizeof(HashEntry *));
+    my_assert(hash_map_init(&map) == -1);
+    mem_deinit();
+
+    mem_init(128 * count);
+    my_assert(hash_map_init(&map) == 0);
+
+    // Concurrent puts grow the table several times on the way.
+    pthread_t threads[num_threads];
+    hash_thread_data_t thread_data[num_threads];
+    int per_thread = count / num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        thread_data[i] = (hash_thread_data_t){
+            .map = &map, .start_key = i * per_thread, .num_keys = per_thread};
+        pthread_create(&threads[i], NULL, thread_hash_put, &thread_data[i]);
+    }
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    my_assert(hash_map_count(&map) == (size_t)num_threads * per_thread);
+    my_assert(map.num_buckets * HASH_MAP_LOAD_FACTOR >= hash_map_count(&map));
+
+    // Replacing keeps the count, removing drops it, and lookups follow.
+    my_assert(hash_map_put(&map, 0, NULL) == 0);
+    my_assert(hash_map_count(&map) == (size_t)num_threads * per_thread);
+    void *value = &map;
+    my_assert(hash_map_get(&map, 0, &value) && value == NULL);
+    for (int key = 0; key < num_threads * per_thread; key += 2)
+        my_assert(hash_map_remove(&map, key));
+    my_assert(!hash_map_remove(&map, 0));
+    my_assert(hash_map_count(&map) == (size_t)num_threads * per_thread / 2);
+    for (int key = 0; key < num_threads * per_thread; key++)
+        my_assert(hash_map_get(&map, key, NULL) == key % 2);
+
+    hash_map_cleanup(&map);
+    assert_pool_empty(128 * count);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void *thread_combining_writer(void *arg) {
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < data->num_nodes; i++)
+        list_insert(data->head, data->start_value + i);
+    for (int i = 0; i < data->num_nodes; i += 2)
+        list_delete(data->head, data->start_value + i);
+    return NULL;
+}
+
+void test_list_combining(TestParams *params) {
+    printf_yellow("  Testing flat combining (threads: %d, nodes: %d) ---> ",
+                  params->num_threads, params->num_nodes);
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * params->num_nodes);
+    list_set_combining(1);
+
+    // Alone, a writer combines its own requests in program order.
+    for (int i = 0; i < 4; i++) list_insert(&head, i);
+    list_delete(&head, 0);
+    my_assert(list_has_values(head, 1, 3));
+    list_delete(&head, 1);
+    list_delete(&head, 2);
+    list_delete(&head, 3);
+    my_assert(head == NULL);
+
+    // Each thread keeps the odd half of its values.
+    pthread_t threads[params->num_threads];
+    thread_data_t thread_data[params->num_threads];
+    int per_thread = params->num_nodes / params->num_threads;
+    for (int i = 0; i < params->num_threads; i++) {
+        thread_data[i].head = &head;
+        thread_data[i].start_value = i * per_thread;
+        thread_data[i].num_nodes = per_thread;
+        pthread_create(&threads[i], NULL, thread_combining_writer,
+                       &thread_data[i]);
+    }
+    for (int i = 0; i < params->num_threads; i++)
+        pthread_join(threads[i], NULL);
+
+    int remaining = params->num_threads * (per_thread / 2);
+    my_assert(list_count_nodes(&head) == remaining);
+    int odd = 1;
+    for (Node *current = head; current; current = current->next)
+        odd &= current->data % 2;
+    my_assert(odd);
+    for (int i = 1; i < params->num_threads * per_thread; i += 2)
+        my_assert(list_search(&head, i) != NULL);
+
+    list_set_combining(0);
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+typedef struct {
+    CompactList *list;
+    int start_value;
+    int num_nodes;
+} compact_thread_data_t;
+
+void *thread_compact_insert(void *arg) {
+    compact_thread_data_t *data = (compact_thread_data_t *)arg;
+    for (int i = 0; i < data->num_nodes; i++)
+        compact_list_insert(data->list, data->start_value + i);
+    return NULL;
+}
+
+void test_compact_list(int num_threads, int count) {
+    printf_yellow("  Testing list with 32-bit links (threads: %d, nodes: %d) "
+                  "---> ",
+                  num_threads, count);
+    my_assert(sizeof(CompactNode) == 8);
+    size_t size = sizeof(CompactNode) * (count + 1);
+    CompactList list;
+    mem_init(size);
+    compact_list_init(&list);
+
+    pthread_t threads[num_threads];
+    compact_thread_data_t thread_data[num_threads];
+    for (int i = 0; i < num_threads; i++) {
+        thread_data[i].list = &list;
+        thread_data[i].start_value = i * (count / num_threads);
+        thread_data[i].num_nodes = count / num_threads;
+        pthread_create(&threads[i], NULL, thread_compact_insert,
+                       &thread_data[i]);
+    }
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    my_assert(compact_list_count_nodes(&list) == count);
+
+    // Deleting the tail moves it back, and appends follow the new tail.
+    clist_link_t link = compact_list_search(&list, count - 1);
+    my_assert(compact_list_node(link)->data == count - 1);
+    compact_list_delete(&list, compact_list_node(list.tail)->data);
+    link = compact_list_insert_after(&list, list.tail, 12345);
+    my_assert(link == list.tail);
+    compact_list_delete(&list, 12345);
+    compact_list_delete(&list, compact_list_node(list.head)->data);
+    my_assert(compact_list_search(&list, 54321) == COMPACT_LIST_NULL);
+    my_assert(compact_list_count_nodes(&list) == count - 2);
+
+    // A byte copy of the pool is the same list at another address.
+    char *copy = malloc(size);
+    memcpy(copy, mem_base(), size);
+    int seen = 0;
+    uint64_t sum = 0, copy_sum = 0;
+    for (CompactNode *node = compact_list_node(list.head); node;
+         node = compact_list_node(node->next))
+        sum += node->data;
+    for (CompactNode *node = compact_list_at(copy, list.head); node;
+         node = compact_list_at(copy, node->next), seen++)
+        copy_sum += node->data;
+    my_assert(seen == count - 2 && copy_sum == sum);
+    free(copy);
+
+    compact_list_cleanup(&list);
+    assert_pool_empty(size);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// ********* Benchmarks *********
+
+// Chains the nodes in the given order behind the list's back.
+void relink_nodes(Node **head, Node **order, int count) {
+    *head = order[0];
+    for (int i = 0; i < count; i++) {
+        order[i]->next = i + 1 < count ? order[i + 1] : NULL;
+#ifdef LIST_DOUBLY_LINKED
+        order[i]->prev = i > 0 ? order[i - 1] : NULL;
+#endif
+    }
+    list_update_jumps(head);
+}
+
+// Loads a list of `count` nodes and links them in a random order, so that
+// each step of a traversal misses the cache.
+void make_scattered_list(Node **head, int count, const char *path) {
+    // The list_save format: magic, version, count, then the payloads.
+    struct {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t count;
+    } header = {.magic = 0x5453494Cu, .version = 1, .count = count};
+    FILE *file = fopen(path, "wb");
+    my_assert(file != NULL);
+    fwrite(&header, sizeof(header), 1, file);
+    for (int i = 0; i < count; i++) {
+        uint16_t data = i & 0x7fff;
+        fwrite(&data, sizeof(data), 1, file);
+    }
+    fclose(file);
+
+    list_init(head, sizeof(Node) * count);
+    my_assert(list_load(head, path) == 0);
+
+    Node **order = malloc(count * sizeof(Node *));
+    Node *current = *head;
+    for (int i = 0; i < count; i++, current = current->next)
+        order[i] = current;
+    for (int i = count - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        Node *swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+    relink_nodes(head, order, count);
+    free(order);
+}
+
+void test_list_traversal_benchmark() {
+#ifdef LIST_JUMP_POINTERS
+    printf_yellow("  Traversal of scattered lists (jump distance %d):\n",
+                  LIST_JUMP_DISTANCE);
+#else
+    printf_yellow("  Traversal of scattered lists (no jump pointers):\n");
+#endif
+    char path[] = "/tmp/test_list_benchmarkXXXXXX";
+    int fd = mkstemp(path);
+    my_assert(fd >= 0);
+    close(fd);
+
+    // Time single-threaded walks only.
+    list_set_parallelism(1, 0);
+    for (int count = 1 << 14; count <= 1 << 20; count *= 4) {
+        Node *head = NULL;
+        make_scattered_list(&head, count, path);
+        int passes = (1 << 22) / count;
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < passes; i++)
+            my_assert(list_count_nodes(&head) == count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double count_ns = ((end.tv_sec - start.tv_sec) * 1e9 +
+                           (end.tv_nsec - start.tv_nsec)) /
+                          ((double)passes * count);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < passes; i++)
+            my_assert(list_search(&head, 0xffff) == NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double search_ns = ((end.tv_sec - start.tv_sec) * 1e9 +
+                            (end.tv_nsec - start.tv_nsec)) /
+                           ((double)passes * count);
+
+        printf_yellow("    nodes: %7d  count: %6.2f ns/node  search: %6.2f "
+                      "ns/node\n",
+                      count, count_ns, search_ns);
+
+        list_cleanup(&head);
+    }
+    list_set_parallelism(0, 0);
+
+    unlink(path);
+    printf_green("  ... [PASS].\n");
+}
+
+// ********* Scalability *********
+
+void *thread_search_function(void *arg) {
+    thread_data_t *data = (thread_data_t *)arg;
+    for (int i = 0; i < data->num_nodes; i++)
+        list_search(data->head, (data->start_value + i) % 64);
+    return NULL;
+}
+
+void test_list_search_scalability(int num_searches) {
+    printf_yellow("  Read scalability of list_search (%d searches):\n",
+                  num_searches);
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 64);
+    for (int i = 0; i < 64; i++) list_insert(&head, i);
+
+    for (int num_threads = 1; num_threads <= 256; num_threads *= 2) {
+        pthread_t threads[num_threads];
+        thread_data_t thread_data[num_threads];
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < num_threads; i++) {
+            thread_data[i].head = &head;
+            thread_data[i].start_value = i;
+            thread_data[i].num_nodes = num_searches / num_threads;
+            pthread_create(&threads[i], NULL, thread_search_function,
+                           &thread_data[i]);
+        }
+        for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double seconds =
+            (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf_yellow("    threads: %3d  time: %8.3f ms  searches/s: %.0f\n",
+                      num_threads, seconds * 1e3, num_searches / seconds);
+    }
+
+    my_assert(list_count_nodes(&head) == 64);
+    list_cleanup(&head);
+    printf_green("  ... [PASS].\n");
+}
+
+void test_list_delete_node(int count) {
+    printf_yellow("  Testing list_delete_node and list_insert_before ---> ");
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 2 * count);
+    for (int i = 0; i < count; i++) list_insert(&head, 2 * i + 1);
+
+    // Insert an even value before every odd one, then drop the odd ones.
+    Node *current = head;
+    while (current) {
+        Node *next = current->next;
+        list_insert_before(&head, current, current->data - 1);
+        current = next;
+    }
+    current = head;
+    while (current) {
+        Node *next = current->next;
+        if (current->data % 2) list_delete_node(&head, current);
+        current = next;
+    }
+
+    my_assert(list_count_nodes(&head) == count);
+    Node *previous = NULL;
+    current = head;
+    for (int i = 0; i < count; i++) {
+        my_assert(current->data == 2 * i);
+#ifdef LIST_DOUBLY_LINKED
+        my_assert(current->prev == previous);
+#endif
+        previous = current;
+        current = current->next;
+    }
+    my_assert(current == NULL);
+
+    // Removing the head, the tail and a node from no list.
+    Node stray = {.data = 7};
+    list_delete_node(&head, &stray);
+    list_delete_node(&head, head);
+    list_delete_node(&head, previous);
+    my_assert(list_count_nodes(&head) == count - 2);
+    my_assert(head->data == 2);
+#ifdef LIST_DOUBLY_LINKED
+    my_assert(head->prev == NULL);
+#endif
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
 // ********* Stress and edge cases *********
 
 void test_list_insert_loop(int count) {
@@ -659,6 +1997,48 @@ int main(int argc, char *argv[]) {
             " 7. test_list_insert_after - Test multiple insertions after a "
             "given node\n");
         printf(" 8. test_list_delete - Test multiple detelions\n");
+        printf(" 9. test_list_save_load - Test saving and loading a list\n");
+        printf(
+            "10. test_list_parallel_traversal - Test count, search and reduce "
+            "split across workers\n");
+        printf(
+            "11. test_list_search_scalability - Benchmark concurrent "
+            "list_search from 1 to 256 threads\n");
+        printf(
+            "12. test_list_rcu - Test lock-free readers alongside writers in "
+            "RCU mode\n");
+        printf("13. test_sharded_list - Test the hash-sharded list\n");
+        printf(
+            "14. test_list_delete_node - Test deleting and inserting before "
+            "given nodes\n");
+        printf("15. test_intrusive_list - Test the intrusive list\n");
+        printf(
+            "16. test_var_list - Test the list with inline variable-size "
+            "payloads\n");
+        printf("17. test_list_relinearize - Test copying the list into "
+               "traversal order\n");
+        printf("18. test_list_jump_pointers - Test keeping jump pointers up to "
+               "date\n");
+        printf(
+            "19. test_list_traversal_benchmark - Benchmark traversals of "
+            "scattered lists of 16K-1M nodes\n");
+        printf("20. test_list_splice_split - Test moving chains between "
+               "lists\n");
+        printf("21. test_list_sort - Test sorting the list in place\n");
+        printf("22. test_compact_list - Test the list linked by 32-bit pool "
+               "offsets\n");
+        printf("23. test_list_self_organizing - Test move-to-front, transpose "
+               "and finger search\n");
+        printf("24. test_list_search_many - Test looking up many keys in one "
+               "pass\n");
+        printf("25. test_list_apply - Test running a batch of mixed "
+               "operations\n");
+        printf("26. test_packed_list - Test the compressed list of "
+               "bit-packed chunks\n");
+        printf("27. test_replicated_list - Test the per-NUMA-node replicated "
+               "list\n");
+        printf("28. test_hash_map - Test the concurrent hash map\n");
+        printf("29. test_list_combining - Test flat combining of writes\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -685,16 +2065,51 @@ int main(int argc, char *argv[]) {
                 for (int j = 8; j < 15;
                      j++)  // from 2^8 = 256 up to 2^14 = 16384 nodes
                 {
-                    test_list_insert_multithread(&(TestParams){
-                        .num_threads = pow(2, i), .num_nodes = pow(2, j)});
-                    test_list_insert_after_multithread(&(TestParams){
-                        .num_threads = pow(2, i), .num_nodes = pow(2, j)});
-                    test_list_insert_before_multithreaded(&(TestParams){
-                        .num_threads = pow(2, i), .num_nodes = pow(2, j)});
-                    test_list_delete_multithreaded(&(TestParams){
-                        .num_threads = pow(2, i), .num_nodes = pow(2, j)});
+                    // One pool per configuration, emptied between the tests
+                    // with list_reset instead of being set up four times.
+                    Node *head = NULL;
+                    int num_threads = pow(2, i), num_nodes = pow(2, j);
+                    list_init(&head, sizeof(Node) * (num_threads + num_nodes +
+                                                     1));
+                    TestParams params = {.num_threads = num_threads,
+                                         .num_nodes = num_nodes,
+                                         .head = &head};
+                    test_list_insert_multithread(&params);
+                    test_list_insert_after_multithread(&params);
+                    test_list_insert_before_multithreaded(&params);
+                    test_list_delete_multithreaded(&params);
+                    list_cleanup(&head);
                 }
 
+            printf("\nTesting additional operations:\n");
+            test_list_cleanup();
+            test_list_save_load(16384);
+            test_list_parallel_traversal(4096);
+            test_list_delete_node(1024);
+            for (int i = 1; i < 6; i++)
+                test_list_rcu(
+                    &(TestParams){.num_threads = pow(2, i), .num_nodes = 256});
+            for (int i = 0; i < 9; i += 2)
+                test_sharded_list_multithread(&(TestParams){
+                    .num_threads = pow(2, i), .num_nodes = 4096});
+            for (int i = 0; i < 9; i += 2)
+                test_intrusive_list_multithread(&(TestParams){
+                    .num_threads = pow(2, i), .num_nodes = 1024});
+            test_var_list(1024);
+            test_list_relinearize(4096);
+            test_list_jump_pointers(1024);
+            test_list_splice_split(4096);
+            test_list_sort(4096);
+            for (int i = 0; i < 9; i += 2)
+                test_compact_list(pow(2, i), 4096);
+            test_list_self_organizing(1024);
+            test_list_search_many(4096, 512);
+            test_list_apply(1024);
+            test_packed_list(65536);
+            test_replicated_list(4, 4096);
+            test_hash_map(4, 65536);
+            test_list_combining(
+                &(TestParams){.num_threads = 16, .num_nodes = 4096});
             break;
         case 1:
             test_list_insert_multithread(&(TestParams){
@@ -740,6 +2155,77 @@ int main(int argc, char *argv[]) {
                     test_list_delete_multithreaded(&(TestParams){
                         .num_threads = pow(2, i), .num_nodes = pow(2, j)});
             break;
+        case 9:
+            test_list_save_load(16384);
+            break;
+        case 10:
+            test_list_parallel_traversal(4096);
+            break;
+        case 11:
+            test_list_search_scalability(1 << 20);
+            break;
+        case 12:
+            for (int i = 1; i < 6; i++)
+                test_list_rcu(
+                    &(TestParams){.num_threads = pow(2, i), .num_nodes = 256});
+            break;
+        case 13:
+            for (int i = 0; i < 9; i += 2)
+                test_sharded_list_multithread(&(TestParams){
+                    .num_threads = pow(2, i), .num_nodes = 4096});
+            break;
+        case 14:
+            test_list_delete_node(1024);
+            break;
+        case 15:
+            for (int i = 0; i < 9; i += 2)
+                test_intrusive_list_multithread(&(TestParams){
+                    .num_threads = pow(2, i), .num_nodes = 1024});
+            break;
+        case 16:
+            test_var_list(1024);
+            break;
+        case 17:
+            test_list_relinearize(4096);
+            break;
+        case 18:
+            test_list_jump_pointers(1024);
+            break;
+        case 19:
+            test_list_traversal_benchmark();
+            break;
+        case 20:
+            test_list_splice_split(4096);
+            break;
+        case 21:
+            test_list_sort(4096);
+            break;
+        case 22:
+            for (int i = 0; i < 9; i += 2)
+                test_compact_list(pow(2, i), 4096);
+            break;
+        case 23:
+            test_list_self_organizing(1024);
+            break;
+        case 24:
+            test_list_search_many(4096, 512);
+            break;
+        case 25:
+            test_list_apply(1024);
+            break;
+        case 26:
+            test_packed_list(65536);
+            break;
+        case 27:
+            test_replicated_list(4, 4096);
+            break;
+        case 28:
+            test_hash_map(4, 65536);
+            break;
+        case 29:
+            test_list_combining(
+                &(TestParams){.num_threads = 16, .num_nodes = 4096});
+            break;
 
         default:
             printf("Invalid test function\n");
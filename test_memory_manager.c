@@ -4,6 +4,7 @@
 #include <math.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -223,6 +224,28 @@ void *test_zero_alloc_and_free(void *arg) {
     return NULL;
 }
 
+void *test_alloc_many_and_free(void *arg) {
+    thread_data_t *data = (thread_data_t *)arg;
+
+    // Allocate a batch of small blocks and fill each with a unique pattern
+    size_t block_size = 16;
+    size_t count = data->block_size / block_size;
+    char *blocks[count];
+    my_assert(mem_alloc_many(block_size, count, (void **)blocks) == count);
+    for (size_t i = 0; i < count; i++)
+        memset(blocks[i], data->thread_id + i, block_size);
+
+    my_barrier_wait(&barrier);
+
+    // Every block must still hold its own pattern, i.e. no overlaps
+    for (size_t i = 0; i < count; i++) {
+        sanityCheck(block_size, blocks[i], (char)(data->thread_id + i));
+        mem_free(blocks[i]);
+    }
+
+    return NULL;
+}
+
 /*
  * This function is used to test the allocation of random blocks of memory and
  * then freeing them in a multithreading context. The test passes if all
@@ -848,6 +871,163 @@ void run_concurrency_test(TestParams params) {
     printf_green("[PASS].\n");
 }
 
+void test_alloc_near() {
+    printf_yellow("  Testing \"mem_alloc_near\" ---> ");
+    mem_init(1024);
+
+    // Fill the pool with 16 blocks of 64 bytes, then punch holes in it.
+    char *blocks[16];
+    for (int i = 0; i < 16; i++) {
+        blocks[i] = mem_alloc(64);
+        my_assert(blocks[i] != NULL);
+    }
+    mem_free(blocks[1]);
+    mem_free(blocks[9]);
+    mem_free(blocks[14]);
+
+    // First fit would take the hole at block 1; the hint picks the nearest.
+    char *near = mem_alloc_near(blocks[12], 32);
+    my_assert(near == blocks[14]);
+    near = mem_alloc_near(blocks[10], 32);
+    my_assert(near == blocks[9] + 32);  // End of the gap closest to the hint
+    near = mem_alloc_near(blocks[2], 64);
+    my_assert(near == blocks[1]);
+
+    // A hint outside the pool falls back to first fit.
+    my_assert(mem_alloc_near(NULL, 32) == blocks[9]);
+    my_assert(mem_alloc_near(blocks[0], 64) == NULL);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_mem_reset() {
+    printf_yellow("  Testing \"mem_reset\" ---> ");
+    int count = 1000;
+    mem_init(16 * count);
+
+    // Fill the pool, reset it, and fill it again from the start.
+    for (int round = 0; round < 100; round++) {
+        char *first = mem_alloc(16);
+        my_assert(first == mem_base());
+        for (int i = 1; i < count; i++) my_assert(mem_alloc(16) != NULL);
+        my_assert(mem_alloc(16) == NULL);
+        mem_reset();
+    }
+
+    // Blocks freed after a reset are reused as usual.
+    void *a = mem_alloc(32);
+    void *b = mem_alloc(32);
+    mem_free(a);
+    my_assert(mem_alloc(16) == a);
+    my_assert(mem_alloc(32) == (char *)b + 32);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_free_many() {
+    printf_yellow("  Testing \"mem_free_many\" ---> ");
+    mem_init(1024);
+
+    // Free every other block, in scrambled order and with a stray address.
+    void *blocks[16], *batch[9];
+    for (int i = 0; i < 16; i++) blocks[i] = mem_alloc(64);
+    for (int i = 0; i < 8; i++) batch[i] = blocks[(i * 6) % 16];
+    batch[8] = (char *)blocks[3] + 1;
+    mem_free_many(batch, 9);
+
+    for (int i = 0; i < 16; i += 2) my_assert(mem_alloc(64) == blocks[i]);
+    my_assert(mem_alloc(64) == NULL);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_alloc_span() {
+    printf_yellow("  Testing \"mem_alloc_span\" ---> ");
+    mem_init(1024);
+
+    // The span skips a gap too small for it and its blocks free one by one.
+    void *blocks[8];
+    void *first = mem_alloc(64);
+    void *second = mem_alloc(64);
+    mem_alloc(64);
+    mem_free(second);
+    my_assert(mem_alloc_span(64, 4, blocks) == 4);
+    for (int i = 0; i < 4; i++)
+        my_assert(blocks[i] == (char *)first + 64 * (3 + i));
+    mem_free(blocks[1]);
+    my_assert(mem_alloc(64) == second);
+    my_assert(mem_alloc(64) == blocks[1]);
+    my_assert(mem_alloc_span(64, 16, blocks) == 0);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Frees blocks of the real allocator whose header bytes, which hold the
+// previous block's data, look like the profiler's own header. The profiler
+// must hand them back untouched.
+void free_foreign_blocks() {
+    void *libc = dlopen("libc.so.6", RTLD_LAZY | RTLD_NOLOAD);
+    void *(*real_malloc)(size_t) = libc ? dlsym(libc, "malloc") : NULL;
+    if (!real_malloc) return;
+
+    for (int i = 0; i < 64; i++) {
+        uint64_t *first = real_malloc(24);
+        uint64_t *second = real_malloc(24);
+        // A tagged size as the profiler once kept it, 16 bytes before
+        // `second`, large enough to show in the live bytes if counted.
+        if (second == first + 4) first[2] = 0xA110ull << 48 | 1ull << 40;
+        free(second);
+        free(first);
+    }
+}
+
+void test_alloc_profiler() {
+    printf_yellow("  Testing the allocation profiler ---> ");
+    char path[] = "/tmp/test_alloc_profileXXXXXX";
+    int fd = mkstemp(path);
+    my_assert(fd >= 0);
+    close(fd);
+
+    // Profile a run of this program that executes no tests, and one that
+    // frees blocks the profiler did not hand out; those must not be counted.
+    const char *runs[] = {"-1", "4"};
+    for (int i = 0; i < 2; i++) {
+        char command[256];
+        snprintf(command, sizeof(command),
+                 "LD_PRELOAD=./liballocprofile.so MEMPROFILE_OUTPUT=%s "
+                 "./test_memory_manager %s > /dev/null",
+                 path, runs[i]);
+        my_assert(system(command) == 0);
+
+        char report[4096] = {0};
+        FILE *file = fopen(path, "r");
+        my_assert(file != NULL);
+        if (file) {
+            my_assert(fread(report, 1, sizeof(report) - 1, file) > 0);
+            fclose(file);
+        }
+        unsigned long mallocs = 0;
+        long live = -1, peak = -1;
+        char *field;
+        if ((field = strstr(report, "\"malloc\": ")))
+            sscanf(field, "\"malloc\": %lu", &mallocs);
+        if ((field = strstr(report, "\"live_bytes\": ")))
+            sscanf(field, "\"live_bytes\": %ld", &live);
+        if ((field = strstr(report, "\"peak_bytes\": ")))
+            sscanf(field, "\"peak_bytes\": %ld", &peak);
+        my_assert(mallocs > 0);
+        my_assert(live >= 0 && peak >= live);
+        my_assert(strstr(report, "\"sizes\": [{\"min\": ") != NULL);
+    }
+
+    unlink(path);
+    printf_green("[PASS].\n");
+}
+
 /* repeated from A1, as there were solutions that has issues */
 
 void test_looking_for_out_of_bounds() {
@@ -903,7 +1083,10 @@ int main(int argc, char *argv[]) {
             "to true.\n");
         printf(
             "  3. test_looking_for_out_of_bounds, needs "
-            "LD_PRELOAD=./libmymalloc.so .\n\n");
+            "LD_PRELOAD=./libmymalloc.so .\n");
+        printf(
+            "  4. free_foreign_blocks, needs "
+            "LD_PRELOAD=./liballocprofile.so .\n\n");
         return 1;
     }
 
@@ -931,6 +1114,10 @@ int main(int argc, char *argv[]) {
                                 (TestParams){.num_threads = base_num_threads,
                                              .memory_size = 1024},
                                 "zero alloc and free");
+            run_concurrent_test(test_alloc_many_and_free,
+                                (TestParams){.num_threads = base_num_threads,
+                                             .memory_size = 1024},
+                                "mem_alloc_many and mem_free");
 
             test_resize_multithread(
                 (TestParams){.num_threads = base_num_threads});
@@ -955,6 +1142,11 @@ int main(int argc, char *argv[]) {
                 .num_threads = base_num_threads, .memory_size = 2048});
             test_random_blocks_multithread((TestParams){
                 .num_threads = base_num_threads, .block_size = 1024});
+            test_alloc_near();
+            test_mem_reset();
+            test_free_many();
+            test_alloc_span();
+            test_alloc_profiler();
 
             break;
 
@@ -1022,6 +1214,10 @@ int main(int argc, char *argv[]) {
             test_looking_for_out_of_bounds();
             break;
 
+        case 4:
+            free_foreign_blocks();
+            break;
+
         default:
             printf("Invalid test function\n");
             break;
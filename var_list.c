@@ -0,0 +1,168 @@
+#include "var_list.h"
+
+#define VAR_NODE_ALIGN 16
+
+/**
+ * @brief Checks whether a payload starts with the list's key prefix.
+ *
+ * @param list A pointer to the list.
+ * @param node The node to check.
+ * @param key The key, `key_size` bytes long.
+ * @return 1 on a match, 0 otherwise.
+ */
+static int key_matches(VarList *list, VarNode *node, const void *key) {
+    return node->size >= list->key_size &&
+           memcmp(node->payload, key, list->key_size) == 0;
+}
+
+/**
+ * @brief Frees the pool block holding a node.
+ *
+ * @param node The node.
+ */
+static void node_free(VarNode *node) {
+    mem_free((unsigned char *)node - node->offset);
+}
+
+/**
+ * @brief Initializes a list whose nodes carry payloads of any size inline.
+ *
+ * @param list A pointer to the list.
+ * @param payload_size The payload size of inserts that pass size 0.
+ * @param key_size The length of the payload prefix compared by
+ * `var_list_search` and `var_list_delete`.
+ */
+void var_list_init(VarList *list, size_t payload_size, size_t key_size) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->payload_size = payload_size;
+    list->key_size = key_size;
+    pthread_rwlock_init(&list->lock, NULL);
+}
+
+/**
+ * @brief Appends a copy of the payload to the list, allocating the node and
+ * its payload with a single `mem_alloc`. The block has room to move the node
+ * up to the next 16-byte boundary, so the payload is aligned wherever the
+ * pool places the block.
+ *
+ * @param list A pointer to the list.
+ * @param payload The bytes to copy into the node.
+ * @param size The payload size in bytes (0 for the list's payload size).
+ * @return A pointer to the new node, or NULL if the allocation failed.
+ */
+VarNode *var_list_insert(VarList *list, const void *payload, size_t size) {
+    if (size == 0) size = list->payload_size;
+
+    unsigned char *block =
+        mem_alloc(sizeof(VarNode) + size + VAR_NODE_ALIGN - 1);
+    if (!block) return NULL;
+    VarNode *new_node = (VarNode *)(((uintptr_t)block + VAR_NODE_ALIGN - 1) &
+                                    ~(uintptr_t)(VAR_NODE_ALIGN - 1));
+    new_node->offset = (unsigned char *)new_node - block;
+    new_node->next = NULL;
+    new_node->size = size;
+    memcpy(new_node->payload, payload, size);
+
+    pthread_rwlock_wrlock(&list->lock);
+    if (list->tail)
+        list->tail->next = new_node;
+    else
+        list->head = new_node;
+    list->tail = new_node;
+    pthread_rwlock_unlock(&list->lock);
+    return new_node;
+}
+
+/**
+ * @brief Removes the first node whose payload starts with the key.
+ *
+ * @param list A pointer to the list.
+ * @param key The key, `key_size` bytes long.
+ */
+void var_list_delete(VarList *list, const void *key) {
+    pthread_rwlock_wrlock(&list->lock);
+
+    VarNode *previous = NULL;
+    VarNode *current = list->head;
+    while (current && !key_matches(list, current, key)) {
+        previous = current;
+        current = current->next;
+    }
+    if (current) {
+        if (previous)
+            previous->next = current->next;
+        else
+            list->head = current->next;
+        if (list->tail == current) list->tail = previous;
+    }
+
+    pthread_rwlock_unlock(&list->lock);
+    if (current) node_free(current);
+}
+
+/**
+ * @brief Searches for the first node whose payload starts with the key.
+ *
+ * @param list A pointer to the list.
+ * @param key The key, `key_size` bytes long.
+ * @return A pointer to the matching node, or NULL if there is none.
+ */
+VarNode *var_list_search(VarList *list, const void *key) {
+    pthread_rwlock_rdlock(&list->lock);
+    VarNode *current = list->head;
+    while (current && !key_matches(list, current, key)) current = current->next;
+    pthread_rwlock_unlock(&list->lock);
+    return current;
+}
+
+/**
+ * @brief Searches for the first node for which the comparator returns 0.
+ *
+ * @param list A pointer to the list.
+ * @param cmp The comparator, called with each payload, its size and the key.
+ * @param key An argument passed through to `cmp`.
+ * @return A pointer to the matching node, or NULL if there is none.
+ */
+VarNode *var_list_find(VarList *list, var_list_cmp_fn cmp, const void *key) {
+    pthread_rwlock_rdlock(&list->lock);
+    VarNode *current = list->head;
+    while (current && cmp(current->payload, current->size, key) != 0)
+        current = current->next;
+    pthread_rwlock_unlock(&list->lock);
+    return current;
+}
+
+/**
+ * @brief Counts the number of nodes in the list.
+ *
+ * @param list A pointer to the list.
+ * @return The number of nodes.
+ */
+int var_list_count_nodes(VarList *list) {
+    int count = 0;
+    pthread_rwlock_rdlock(&list->lock);
+    for (VarNode *current = list->head; current; current = current->next)
+        count++;
+    pthread_rwlock_unlock(&list->lock);
+    return count;
+}
+
+/**
+ * @brief Frees all the nodes in the list.
+ *
+ * @param list A pointer to the list.
+ */
+void var_list_cleanup(VarList *list) {
+    pthread_rwlock_wrlock(&list->lock);
+    VarNode *current = list->head;
+    while (current) {
+        VarNode *next = current->next;
+        node_free(current);
+        current = next;
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    pthread_rwlock_unlock(&list->lock);
+    pthread_rwlock_destroy(&list->lock);
+}
@@ -0,0 +1,39 @@
+#ifndef VAR_LIST_H
+#define VAR_LIST_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory_manager.h"
+
+// A node carrying its payload inline, so each element takes one allocation.
+// Nodes start on a 16-byte boundary inside their pool block, which other
+// structures sharing the pool may leave at any address.
+typedef struct VarNode {
+    struct VarNode *next;
+    size_t size;
+    size_t offset;  // Bytes between the start of the pool block and the node
+    unsigned char payload[] __attribute__((aligned(16)));
+} VarNode;
+
+typedef int (*var_list_cmp_fn)(const void *payload, size_t size,
+                               const void *key);
+
+typedef struct {
+    VarNode *head;
+    VarNode *tail;
+    size_t payload_size;  // Size used by inserts that pass size 0
+    size_t key_size;      // Length of the key prefix compared by search
+    pthread_rwlock_t lock;
+} VarList;
+
+void var_list_init(VarList *list, size_t payload_size, size_t key_size);
+VarNode *var_list_insert(VarList *list, const void *payload, size_t size);
+void var_list_delete(VarList *list, const void *key);
+VarNode *var_list_search(VarList *list, const void *key);
+VarNode *var_list_find(VarList *list, var_list_cmp_fn cmp, const void *key);
+int var_list_count_nodes(VarList *list);
+void var_list_cleanup(VarList *list);
+
+#endif